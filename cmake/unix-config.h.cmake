@@ -22,12 +22,15 @@
 #cmakedefine HAVE_STDLIB_H
 #cmakedefine HAVE_STRINGS_H
 #cmakedefine HAVE_STRING_H
+#cmakedefine HAVE_SYS_EPOLL_H
 #cmakedefine HAVE_SYS_SELECT_H
+#cmakedefine HAVE_SYS_SENDFILE_H
 #cmakedefine HAVE_SYS_SOCKET_H
 #cmakedefine HAVE_SYS_STATVFS_H
 #cmakedefine HAVE_SYS_STAT_H
 #cmakedefine HAVE_SYS_TIME_H
 #cmakedefine HAVE_SYS_TYPES_H
+#cmakedefine HAVE_SYS_UIO_H
 #cmakedefine HAVE_SYS_UN_H
 #cmakedefine HAVE_SYS_WAIT_H
 #cmakedefine HAVE_TERMIOS_H
@@ -38,6 +41,7 @@
 #cmakedefine HAVE_WS2TCPIP_H
 
 /* functions */
+#cmakedefine HAVE_ACCEPT4
 #cmakedefine HAVE_ACCESS
 #cmakedefine HAVE_ALARM
 #cmakedefine HAVE_ATOLL
@@ -46,6 +50,7 @@
 #cmakedefine HAVE_CLOCK_GETTIME
 #cmakedefine HAVE_DECL_STRERROR_R
 #cmakedefine HAVE_DOPRNT
+#cmakedefine HAVE_EPOLL_CREATE1
 #cmakedefine HAVE_EXP2
 #cmakedefine HAVE_FLOOR
 #cmakedefine HAVE_FORK
@@ -104,6 +109,7 @@
 #cmakedefine HAVE_SETUID
 #cmakedefine HAVE_SETUID
 #cmakedefine HAVE_SLEEP
+#cmakedefine HAVE_SENDFILE
 #cmakedefine HAVE_SOCKET
 #cmakedefine HAVE_STRCASECMP
 #cmakedefine HAVE_STRCASESTR
@@ -127,6 +133,7 @@
 #cmakedefine HAVE_VPRINTF
 #cmakedefine HAVE_WORKING_FORK
 #cmakedefine HAVE_WORKING_VFORK
+#cmakedefine HAVE_WRITEV
 #cmakedefine STRERROR_R_CHAR_P
 
 /* OpenSSL */
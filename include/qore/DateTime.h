@@ -94,6 +94,7 @@ class DateTime {
    friend class DateTimeNode;
    friend class qore_relative_time;
    friend class qore_absolute_time;
+   friend class QoreDateFormat;
 
 protected:
    //! private date data - most are ints so relative dates can hold a lot of data
@@ -476,6 +477,17 @@ public:
    //! returns the broken-down time in the current time zone
    DLLEXPORT void getInfo(qore_tm &info) const;
 
+   //! returns the broken-down time for each of the given second offsets from the epoch in the given time zone (zone = 0 means UTC)
+   /** this is more efficient than creating a DateTime value for each offset; the time zone lookups are fastest when the offsets are sorted
+       @param zone the time zone for the broken-down times
+       @param epoch an array of second offsets from 1970-01-01Z
+       @param count the number of elements in the \a epoch and \a info arrays
+       @param info the output array for the broken-down times
+
+       @since %Qore 0.8.13
+   */
+   DLLEXPORT static void getInfo(const AbstractQoreZoneInfo* zone, const int64* epoch, size_t count, qore_tm* info);
+
    //! changes the time zone for the time without updating the epoch offset
    DLLEXPORT void setZone(const AbstractQoreZoneInfo* n_zone);
 
@@ -46,6 +46,7 @@
 
 class FtpResp;
 class Queue;
+class QoreSSLContext;
 
 //! provides thread-safe access to FTP servers through Qore data structures
 /**
@@ -345,6 +346,11 @@ public:
     */
    DLLLOCAL int getTimeout() const;
 
+   //! sets the shared TLS/SSL context for the control and data connections; 0 clears it
+   /** @since Qore 0.8.13
+    */
+   DLLLOCAL void setSSLContext(QoreSSLContext* ctx);
+
    //! sets the same event queue for data and control sockets
    DLLLOCAL void setEventQueue(Queue *cbq, ExceptionSink *xsink);
 
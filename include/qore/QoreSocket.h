@@ -1713,6 +1713,15 @@ public:
    //! returns true if a HTTP header was read indicating chunked transfer encoding, but no chunked body has been read
    DLLEXPORT bool pendingHttpChunkedBody() const;
 
+   //! returns true if a complete HTTP header and any message body declared with a Content-Length header can be read without blocking
+   /** any data available on the socket is read into the socket's read buffer; the method never blocks
+
+       @param xsink if an error occurs, the Qore-language exception information will be added here
+
+       @since %Qore 0.8.13
+   */
+   DLLEXPORT bool isHttpMessageBuffered(ExceptionSink* xsink);
+
    //! sets the SSL verification mode
    /** If no SSL connection is in place, then the mode is saved for use with future SSL connections.
 
@@ -39,8 +39,11 @@
 #include <qore/AbstractPrivateData.h>
 #include <qore/QoreThreadLock.h>
 
+#include <vector>
+
 class QoreSSLCertificate;
 class QoreSSLPrivateKey;
+class QoreSSLContext;
 class Queue;
 class my_socket_priv;
 
@@ -203,10 +206,35 @@ public:
    DLLEXPORT QoreHashNode* getUsageInfo() const;
    DLLEXPORT void clearStats();
    DLLEXPORT bool pendingHttpChunkedBody() const;
+   DLLEXPORT bool isHttpMessageBuffered(ExceptionSink* xsink);
    DLLEXPORT void setSslVerifyMode(int mode);
    DLLEXPORT int getSslVerifyMode() const;
    DLLEXPORT void acceptAllCertificates(bool accept_all = true);
    DLLEXPORT bool getAcceptAllCertificates() const;
+
+   // sets the shared TLS/SSL context for new TLS/SSL connections; 0 clears it
+   DLLLOCAL void setSSLContext(QoreSSLContext* ctx);
+   // returns true if the current TLS/SSL connection resumed a previous session
+   DLLLOCAL bool isSSLSessionReused() const;
+   // sets the size of the buffer used for buffered socket reads
+   DLLLOCAL int setReadBufferSize(int64 size, ExceptionSink* xsink);
+   // returns the size of the buffer used for buffered socket reads
+   DLLLOCAL int64 getReadBufferSize() const;
+   // returns true if data has already been read from the socket and can be returned without waiting; returns
+   // false without checking if the socket is in use by another thread
+   DLLLOCAL bool hasBufferedData() const;
+   // resolves the name into the DNS cache in a background thread
+   DLLLOCAL int resolveAsync(const char* host, const char* service, int family, ExceptionSink* xsink);
+   // reads a complete WebSocket message
+   DLLLOCAL QoreHashNode* readWebSocketMessage(int timeout_ms, int64 max_size, ExceptionSink* xsink);
+   // accepts all pending connections up to max after waiting for the first one
+   DLLLOCAL int acceptBatch(std::vector<QoreSocketObject*>& rv, int max, int timeout_ms, ExceptionSink* xsink);
+   // read and parse HTTP header, optionally without setting the socket's character encoding
+   DLLLOCAL QoreHashNode* readHTTPHeader(ExceptionSink* xsink, QoreHashNode* info, int timeout_ms, bool set_encoding);
+   // sets or clears the flag to set SO_REUSEPORT when binding
+   DLLLOCAL int setReusePort(bool reuseport, ExceptionSink* xsink);
+   // returns the flag to set SO_REUSEPORT when binding
+   DLLLOCAL bool getReusePort() const;
 };
 
 #endif // _QORE_QORE_SOCKET_OBJECT_H
@@ -38,18 +38,30 @@
 #include <qore/QoreCondition.h>
 #include <qore/AbstractThreadResource.h>
 
+#include <atomic>
+
 class VLock;
+class ThreadResourceList;
 
 class QoreCondition;
 
 class AbstractSmartLock : public AbstractThreadResource {
+   friend class ThreadResourceList;
+
 protected:
    enum lock_status_e { Lock_Deleted = -2, Lock_Unlocked = -1 };
-   
-   VLock *vl;
-   int tid, waiting;
+
+   // the owner's lock list; set by the owner after acquiring the lock and cleared before releasing it
+   std::atomic<VLock*> vl;
+   // tid can be changed without asl_lock by locks implementing the fast path; waiting is only incremented with asl_lock held
+   std::atomic<int> tid, waiting;
    cond_map_t cmap;       // map of condition variables to wait counts
 
+   // intrusive link in the owning thread's resource list; only modified by the owning thread
+   AbstractSmartLock* trl_prev = nullptr,
+      * trl_next = nullptr;
+   ThreadResourceList* trl = nullptr;
+
    virtual int releaseImpl() = 0;
    virtual int releaseImpl(ExceptionSink *xsink) = 0;
    virtual int grabImpl(int mtid, VLock *nvl, ExceptionSink *xsink, int64 timeout_ms = 0) = 0;
@@ -61,8 +73,27 @@ protected:
    DLLLOCAL virtual void signalImpl();
    DLLLOCAL virtual void cleanupImpl();
 
+   // tries to acquire the lock without asl_lock; returns true if handled, in which case rc has the grabImpl() return value
+   /** must not block; if false is returned, then the normal path with asl_lock held is used
+    */
+   DLLLOCAL virtual bool grabFastImpl(int mtid, int& rc) {
+      return false;
+   }
+
+   // tries to release the lock without asl_lock; returns true if handled, in which case rc has the releaseImpl() return value
+   DLLLOCAL virtual bool releaseFastImpl(int mtid, int& rc) {
+      return false;
+   }
+
    DLLLOCAL void mark_and_push(int mtid, VLock *nvl);
    DLLLOCAL void release_and_signal();
+   // releases a lock held by the current thread without asl_lock and wakes up any waiting threads
+   DLLLOCAL void release_fast(int mtid);
+   // acquires the lock with a CAS if it's unlocked; returns the previous tid in t if not
+   DLLLOCAL bool cas_grab(int mtid, int& t) {
+      t = Lock_Unlocked;
+      return tid.compare_exchange_strong(t, mtid);
+   }
    DLLLOCAL void grab_intern(int mtid, VLock *nvl);
    DLLLOCAL void release_intern();
    DLLLOCAL int verify_wait_unlocked(int mtid, ExceptionSink *xsink);
@@ -71,7 +102,7 @@ public:
    mutable QoreThreadLock asl_lock;
    QoreCondition asl_cond;
 
-   DLLLOCAL AbstractSmartLock() : vl(NULL), tid(-1), waiting(0)  {}
+   DLLLOCAL AbstractSmartLock() : vl(nullptr), tid(-1), waiting(0)  {}
    DLLLOCAL virtual ~AbstractSmartLock() {}
    DLLLOCAL void destructor(ExceptionSink *xsink);
    DLLLOCAL virtual void cleanup(ExceptionSink *xsink);
@@ -91,8 +122,8 @@ public:
 
    DLLLOCAL int extern_wait(QoreCondition *cond, ExceptionSink *xsink, int64 timeout_ms = 0);
 
-   DLLLOCAL int get_tid() const { return tid; }
-   DLLLOCAL int get_waiting() const { return waiting; }
+   DLLLOCAL int get_tid() const { return tid.load(); }
+   DLLLOCAL int get_waiting() const { return waiting.load(); }
    DLLLOCAL virtual const char *getName() const = 0;
    DLLLOCAL int cond_count(QoreCondition *cond) const {
       AutoLocker al(&asl_lock);
@@ -32,6 +32,7 @@
 #ifndef _QORE_BUFFEREDSTREAMREADER_H
 #define _QORE_BUFFEREDSTREAMREADER_H
 
+#include <algorithm>
 #include <cstdint>
 
 #include "qore/qore_bitopts.h"
@@ -42,11 +43,15 @@
 #define DefaultStreamBufferSize 4096
 
 //! Private data for the Qore::BufferedStreamReader class.
+/** Buffered data is held between a head offset and the end of the valid data; reads advance the head and the
+    remaining data is only moved to the start of the buffer when more space is needed to read from the stream.
+ */
 class BufferedStreamReader : public StreamReader {
 public:
    DLLLOCAL BufferedStreamReader(ExceptionSink* xsink, InputStream* is, const QoreEncoding* encoding, int64 bufsize = DefaultStreamBufferSize) :
       StreamReader(xsink, is, encoding),
       bufCapacity((size_t)bufsize),
+      bufStart(0),
       bufCount(0),
       buf(0) {
       if (bufsize <= 0) {
@@ -65,6 +70,122 @@ public:
 
    DLLLOCAL virtual const char* getName() const override { return "BufferedStreamReader"; }
 
+   using StreamReader::readLine;
+
+   //! Returns a pointer to the buffered data without consuming it; reads from the stream if necessary.
+   /** @param size returns the number of bytes available at the pointer returned; 0 means end of stream or error
+       @param xsink exception sink
+       @param min the minimum number of bytes to make available if possible before the end of the stream; must not exceed the buffer capacity
+
+       @return a pointer to the buffered data, valid until the next call to any other method of this object
+    */
+   DLLLOCAL const char* peekSpan(qore_size_t& size, ExceptionSink* xsink, qore_size_t min = 1) {
+      assert(min && min <= bufCapacity);
+      while (bufCount < min) {
+         int64 rc = fillBuffer(bufCapacity - bufCount, xsink);
+         if (!rc)
+            break;
+      }
+      size = *xsink ? 0 : bufCount;
+      return buf + bufStart;
+   }
+
+   //! Discards the given number of bytes from the buffer after a call to peekSpan().
+   DLLLOCAL void consume(qore_size_t bytes) {
+      assert(bytes <= bufCount);
+      bufCount -= bytes;
+      bufStart = bufCount ? bufStart + bytes : 0;
+   }
+
+   //! Reads a line terminated by the given EOL string by searching the buffer in place.
+   DLLLOCAL virtual QoreStringNode* readLineEol(const QoreString* eol, bool trim, ExceptionSink* xsink) override {
+      TempEncodingHelper eolstr(eol, enc, xsink);
+      if (*xsink)
+         return 0;
+      eolstr.removeBom();
+
+      const char* eb = eolstr->c_str();
+      qore_size_t el = eolstr->size();
+      if (!el || el > bufCapacity)
+         return StreamReader::readLineEol(eol, trim, xsink);
+
+      SimpleRefHolder<QoreStringNode> str(new QoreStringNode(enc));
+
+      while (true) {
+         qore_size_t size;
+         const char* p = peekSpan(size, xsink, el);
+         if (*xsink)
+            return 0;
+         if (!size)
+            return str->empty() ? 0 : q_remove_bom_utf16(str.release(), enc);
+
+         // check for an EOL string split between the data already read and the buffer
+         if (el > 1 && !str->empty()) {
+            for (qore_size_t k = QORE_MIN(el - 1, str->size()); k; --k) {
+               if (size >= el - k && !memcmp(str->c_str() + str->size() - k, eb, k) && !memcmp(p, eb + k, el - k)) {
+                  if (trim)
+                     str->terminate(str->size() - k);
+                  else
+                     str->concat(p, el - k);
+                  consume(el - k);
+                  return q_remove_bom_utf16(str.release(), enc);
+               }
+            }
+         }
+
+         const char* f = std::search(p, p + size, eb, eb + el);
+         if (f != p + size) {
+            qore_size_t len = f - p;
+            str->concat(p, trim ? len : len + el);
+            consume(len + el);
+            return q_remove_bom_utf16(str.release(), enc);
+         }
+
+         str->concat(p, size);
+         consume(size);
+      }
+   }
+
+   //! Reads a line terminated by \c "\n", \c "\r", or \c "\r\n" by searching the buffer in place.
+   DLLLOCAL virtual QoreStringNode* readLine(bool trim, ExceptionSink* xsink) override {
+      SimpleRefHolder<QoreStringNode> str(new QoreStringNode(enc));
+
+      while (true) {
+         qore_size_t size;
+         const char* p = peekSpan(size, xsink);
+         if (*xsink)
+            return 0;
+         if (!size) // End of stream.
+            return str->empty() ? 0 : str.release();
+
+         const char* e = static_cast<const char*>(memchr(p, '\n', size));
+         const char* r = static_cast<const char*>(memchr(p, '\r', e ? e - p : size));
+         if (r)
+            e = r;
+         if (!e) {
+            str->concat(p, size);
+            consume(size);
+            continue;
+         }
+
+         qore_size_t len = e - p;
+         str->concat(p, trim ? len : len + 1);
+         consume(len + 1);
+
+         if (*e == '\r') {
+            int64 c = peek(xsink);
+            if (*xsink)
+               return 0;
+            if (c == '\n') {
+               consume(1);
+               if (!trim)
+                  str->concat('\n');
+            }
+         }
+         return str.release();
+      }
+   }
+
 private:
    //! Read data until a limit.
    /** @param xsink exception sink
@@ -83,13 +204,9 @@ private:
 
       if (bufCount) {
          read = QORE_MIN(limit, bufCount);
-         memmove(destPtr, buf, read);
-         if (limit < bufCount) {
-            shiftBuffer(limit);
-            return limit;
-         }
-         bufCount = 0;
-         if (!limit - read)
+         memcpy(destPtr, buf + bufStart, read);
+         consume(read);
+         if (read == limit)
             return read;
       }
 
@@ -131,8 +248,8 @@ private:
          }
          assert(rc > 0);
          size_t len = QORE_MIN((size_t)rc, to_read);
-         memcpy(destPtr + read, buf, len);
-         shiftBuffer(len);
+         memcpy(destPtr + read, buf + bufStart, len);
+         consume(len);
          read += len;
          assert(((limit - read) && !bufCount) || !(limit - read));
       }
@@ -149,98 +266,32 @@ private:
       if (!bufCount) {
          int rc = fillBuffer(bufCapacity, xsink);
          if (!rc)
-            return -1;
-         if (rc < 0)
-            return -2;
+            return *xsink ? -2 : -1;
       }
-      return buf[0];
+      return static_cast<unsigned char>(buf[bufStart]);
    }
 
    //! returns 0 = no data read (end of stream or error), > 0 = number of bytes read, increments bufCount
+   /** the buffered data is moved to the start of the buffer first if there is not enough space after it
+    */
    DLLLOCAL int64 fillBuffer(qore_size_t bytes, ExceptionSink* xsink) {
       assert(bytes);
       assert(bufCount + bytes <= bufCapacity);
-      int64 rc = in->read(buf + bufCount, bytes, xsink);
+      if (bufStart + bufCount + bytes > bufCapacity) {
+         memmove(buf, buf + bufStart, bufCount);
+         bufStart = 0;
+      }
+      int64 rc = in->read(buf + bufStart + bufCount, bytes, xsink);
       if (*xsink)
          return 0;
       bufCount += rc;
       return rc;
    }
 
-   DLLLOCAL bool prepareEnoughData(qore_size_t bytes, ExceptionSink* xsink) {
-      if (bytes > bufCapacity) {
-         xsink->raiseException("STREAM-BUFFER-ERROR", "a read of " QSD " bytes was attempted on a BufferedStreamReader with a capacity of " QSD " bytes", bytes, bufCapacity);
-         return false;
-      }
-      if (bufCount < bytes) {
-         while (true) {
-            int64 rc = fillBuffer(bytes - bufCount, xsink);
-            if (*xsink) {
-               return false;
-            }
-            if (rc == 0) {
-               xsink->raiseException("END-OF-STREAM-ERROR", "a read of " QSD " bytes cannot be performed because there is not enough data available in the stream to satisfy the request", bytes);
-               return false;
-            }
-            if (bufCount >= bytes)
-               break;
-         }
-      }
-      return true;
-   }
-
-   DLLLOCAL void shiftBuffer(qore_size_t bytes) {
-      assert(bytes <= bufCount && bytes > 0);
-      bufCount -= bytes;
-      memmove(buf, buf+bytes, bufCount);
-   }
-
-   //! Try to find EOL in buffer and write it's size to eolLen parameter.
-   /** @param eol end-of-line string
-       @param eolLen size of eol in bytes
-       @param endOfStream whether this is end of the stream
-    */
-   DLLLOCAL const char* findEolInBuffer(const QoreStringNode* eol, qore_size_t& eolLen, bool endOfStream, char& pmatch) const {
-      pmatch = '\0';
-      if (eol) {
-         const char* p = strstr(buf, eol->getBuffer());
-         eolLen = eol->strlen();
-         return p;
-      }
-      else {
-         const char* p = strpbrk(buf, "\n\r"); // Find first occurence of '\n' or '\r'.
-         if (p) { // Found end of line.
-            if (*p == '\n') {
-               eolLen = 1;
-            }
-            else { // *p == '\r'
-               if (*(p+1) == '\n') {
-                  eolLen = 2;
-               }
-               // '\r' is the last character in the buffer, '\n' could be next in the stream.
-               // Unless this is the end of the stream.
-               else if (static_cast<qore_size_t>(p - buf + 1) == bufCount) {
-                  eolLen = 1;
-                  if (!endOfStream) {
-                     pmatch = *p;
-                     p = 0;
-                  }
-               }
-               else {
-                  eolLen = 1;
-               }
-            }
-         }
-         else {
-            eolLen = 0;
-         }
-         return p;
-      }
-   }
-
 private:
    qore_size_t bufCapacity; //! Total capacity of buf.
-   qore_size_t bufCount; //! Current size of data in buf.
+   qore_size_t bufStart; //! Offset of the first byte of buffered data in buf.
+   qore_size_t bufCount; //! Current size of data in buf starting at bufStart.
    char* buf;
 };
 
@@ -0,0 +1,223 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  CsvRecordBuilder.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_CSVRECORDBUILDER_H
+#define _QORE_CSVRECORDBUILDER_H
+
+#include "qore/intern/QoreRegex.h"
+#include "qore/intern/QC_TimeZone.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+DLLEXPORT extern qore_classid_t CID_CSVRECORDBUILDER;
+DLLLOCAL extern QoreClass* QC_CSVRECORDBUILDER;
+
+DLLLOCAL QoreClass* initCsvRecordBuilderClass(QoreNamespace& ns);
+
+// field conversion types supported natively
+enum csv_field_type_e {
+   CFT_STRING = 0,
+   CFT_INT = 1,
+   CFT_FLOAT = 2,
+   CFT_NUMBER = 3,
+   CFT_DATE = 4,
+};
+
+// compiled field description for a single output field in a record
+class CsvFieldSpec {
+public:
+   // output field name
+   std::string name;
+   // index in the input value list
+   size_t idx;
+   // conversion type
+   csv_field_type_e type;
+   // "or nothing" type: empty input values are converted to NOTHING
+   bool or_nothing;
+   // optional date format
+   QoreString* format = nullptr;
+   // optional time zone for dates; only valid if has_zone is true (0 = UTC)
+   const AbstractQoreZoneInfo* zone = nullptr;
+   bool has_zone = false;
+   // optional callable value for post-processing the converted value
+   ResolvedCallReferenceNode* code = nullptr;
+
+   DLLLOCAL CsvFieldSpec(const char* n_name, size_t n_idx, csv_field_type_e n_type, bool n_or_nothing) : name(n_name), idx(n_idx), type(n_type), or_nothing(n_or_nothing) {
+   }
+
+   DLLLOCAL void del(ExceptionSink* xsink) {
+      delete format;
+      if (code)
+         code->deref(xsink);
+   }
+};
+
+// a single field matching rule for record type identification
+class CsvFieldRule {
+public:
+   // the index in the input value list
+   size_t idx;
+   // a compiled regular expression, if any
+   QoreRegex* regex = nullptr;
+   // a value to compare to, if no regex is present
+   AbstractQoreNode* value = nullptr;
+
+   DLLLOCAL CsvFieldRule(size_t n_idx) : idx(n_idx) {
+   }
+
+   DLLLOCAL void del(ExceptionSink* xsink) {
+      if (regex)
+         regex->deref();
+      if (value)
+         value->deref(xsink);
+   }
+
+   DLLLOCAL bool match(const AbstractQoreNode* v, ExceptionSink* xsink) const;
+};
+
+typedef std::vector<CsvFieldRule> csv_rule_list_t;
+
+// a record type and the rules used to identify it
+class CsvRecordRule {
+public:
+   std::string type;
+   csv_rule_list_t rules;
+
+   DLLLOCAL CsvRecordRule(const char* n_type) : type(n_type) {
+   }
+};
+
+typedef std::vector<CsvRecordRule> csv_record_rule_list_t;
+
+/**
+ * @brief Private data for the Qore::CsvRecordBuilder class.
+ *
+ * Tokenizes CSV lines and builds typed records from the resulting values; objects of this class
+ * are not thread safe and are meant to be owned by a single CSV iterator
+ */
+class CsvRecordBuilder : public AbstractPrivateData {
+public:
+   DLLLOCAL CsvRecordBuilder(const QoreString& n_sep, const QoreString& n_quote, bool n_trim, const QoreStringNode* n_date_format, const TimeZoneData* n_zone) :
+      sep(n_sep), quote(n_quote), trim(n_trim), date_format(n_date_format ? new QoreString(*n_date_format) : nullptr), zone(n_zone ? n_zone->get() : nullptr), has_zone(n_zone) {
+   }
+
+   DLLLOCAL virtual void deref(ExceptionSink* xsink) {
+      if (ROdereference()) {
+         clearRecords(xsink);
+         clearRules(xsink);
+         delete this;
+      }
+   }
+
+   //! splits the line into a list of strings according to the separator and quote
+   DLLLOCAL QoreListNode* split(const QoreString* line, ExceptionSink* xsink);
+
+   //! sets the field description for the given record type
+   DLLLOCAL int setRecord(const QoreString* type, const QoreHashNode* spec, const QoreListNode* order, ExceptionSink* xsink);
+
+   //! sets record type rules; the hash is keyed by field count, values are hashes of record type -> list of rule hashes
+   DLLLOCAL int setRules(const QoreHashNode* rules, ExceptionSink* xsink);
+
+   //! returns the first record type matching the given values according to the rules, if any
+   DLLLOCAL QoreStringNode* matchRule(const QoreListNode* values, ExceptionSink* xsink) const;
+
+   //! returns a hash with "spec_fields" and "all_fields" keys for the given record type and input values
+   DLLLOCAL QoreHashNode* build(const QoreString* type, const QoreListNode* values, ExceptionSink* xsink) const;
+
+   DLLLOCAL bool hasRecord(const QoreString* type) const {
+      return rmap.find(type->getBuffer()) != rmap.end();
+   }
+
+   DLLLOCAL const QoreString& getSeparator() const {
+      return sep;
+   }
+
+   DLLLOCAL const QoreString& getQuote() const {
+      return quote;
+   }
+
+protected:
+   typedef std::vector<CsvFieldSpec> csv_field_list_t;
+   typedef std::map<std::string, csv_field_list_t> csv_record_map_t;
+   typedef std::map<size_t, csv_record_rule_list_t> csv_rule_map_t;
+
+   // separator and quote strings as given
+   QoreString sep, quote;
+   // trim unquoted fields
+   bool trim;
+   // the default date format, if any
+   QoreString* date_format;
+   // the default time zone; only valid if has_zone is true, otherwise the current time zone is used
+   const AbstractQoreZoneInfo* zone;
+   bool has_zone;
+
+   // separator and quote converted to the encoding of the last line split
+   QoreString esep, equote;
+   const QoreEncoding* last_enc = nullptr;
+
+   // record type -> field list
+   csv_record_map_t rmap;
+   // field count -> record rules
+   csv_rule_map_t rule_map;
+
+   DLLLOCAL ~CsvRecordBuilder() {
+      delete date_format;
+   }
+
+   DLLLOCAL void clearRecord(csv_field_list_t& fl, ExceptionSink* xsink) {
+      for (auto& i : fl)
+         i.del(xsink);
+      fl.clear();
+   }
+
+   DLLLOCAL void clearRecords(ExceptionSink* xsink) {
+      for (auto& i : rmap)
+         clearRecord(i.second, xsink);
+      rmap.clear();
+   }
+
+   DLLLOCAL void clearRules(ExceptionSink* xsink) {
+      for (auto& i : rule_map) {
+         for (auto& ri : i.second) {
+            for (auto& fi : ri.rules)
+               fi.del(xsink);
+         }
+      }
+      rule_map.clear();
+   }
+
+   // returns the converted value; the caller owns the reference returned
+   DLLLOCAL AbstractQoreNode* convert(const CsvFieldSpec& fs, const QoreStringNode* val, ExceptionSink* xsink) const;
+};
+
+#endif
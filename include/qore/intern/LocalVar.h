@@ -334,16 +334,18 @@ private:
       parse_assigned = false;
    const QoreTypeInfo* typeInfo;
    const QoreTypeInfo* refTypeInfo;
+   // the slot index of the variable in the frame where it was last found at runtime, -1 = unknown
+   mutable std::atomic<int> slot_hint;
 
    DLLLOCAL LocalVarValue* get_var() const {
-      return thread_find_lvar(name.c_str());
+      return thread_find_lvar(name.c_str(), slot_hint);
    }
 
 public:
-   DLLLOCAL LocalVar(const char* n_name, const QoreTypeInfo* ti) : name(n_name), typeInfo(ti), refTypeInfo(QoreTypeInfo::getReferenceTarget(ti)) {
+   DLLLOCAL LocalVar(const char* n_name, const QoreTypeInfo* ti) : name(n_name), typeInfo(ti), refTypeInfo(QoreTypeInfo::getReferenceTarget(ti)), slot_hint(-1) {
    }
 
-   DLLLOCAL LocalVar(const LocalVar& old) : name(old.name), closure_use(old.closure_use), parse_assigned(old.parse_assigned), typeInfo(old.typeInfo), refTypeInfo(old.refTypeInfo) {
+   DLLLOCAL LocalVar(const LocalVar& old) : name(old.name), closure_use(old.closure_use), parse_assigned(old.parse_assigned), typeInfo(old.typeInfo), refTypeInfo(old.refTypeInfo), slot_hint(-1) {
    }
 
    DLLLOCAL ~LocalVar() {
@@ -445,6 +445,28 @@ protected:
    // list of module directories
    UniqueDirectoryList moduleDirList;
 
+   // cached listing of a module directory
+   struct ModuleDirIndex {
+      // the directory's modification time when the listing was read
+      time_t mtime;
+      // true if the listing was read in the same second as the directory was modified, in which case a later
+      // change might not be reflected in the modification time
+      bool racy;
+      // file names in the directory
+      strset_t files;
+   };
+   typedef std::map<std::string, ModuleDirIndex> mod_dir_index_map_t;
+   // module directory -> cached listing; used to find modules without probing every possible module file name
+   mod_dir_index_map_t mod_dir_index;
+
+   // returns the file names in the given module directory, rereading the directory if it has been modified;
+   // returns 0 if the directory cannot be indexed, in which case module files must be checked individually
+   DLLLOCAL const strset_t* getModuleDirIndex(const std::string& dir);
+
+   // returns the user module already parsed from the given file for the given feature if the file is unchanged,
+   // or 0 if the module must be parsed
+   DLLLOCAL QoreAbstractModule* findParsedUserModule(const char* path, const char* feature, time_t mtime, int64 size);
+
    DLLLOCAL QoreAbstractModule* findModuleUnlocked(const char* name) {
       module_map_t::iterator i = map.find(name);
       return i == map.end() ? 0 : i->second;
@@ -650,6 +672,13 @@ protected:
    QoreProgram* pgm;
    QoreClosureParseNode* del; // deletion closure
 
+   // the module file's modification time and size when it was parsed
+   time_t mtime = 0;
+   int64 fsize = -1;
+   // true if the file was parsed in the same second as it was modified, or if it was not parsed from a file, in
+   // which case the parsed module cannot be reused for the same file
+   bool racy = true;
+
    DLLLOCAL virtual void addToProgramImpl(QoreProgram* pgm, ExceptionSink& xsink) const;
 
 public:
@@ -665,6 +694,18 @@ public:
       return pgm;
    }
 
+   // records the modification time and size of the module file before it is parsed
+   DLLLOCAL void setFileInfo(time_t n_mtime, int64 n_size) {
+      mtime = n_mtime;
+      fsize = n_size;
+      racy = time(0) <= n_mtime;
+   }
+
+   // returns true if the module file has not been modified since it was parsed
+   DLLLOCAL bool fileUnchanged(time_t n_mtime, int64 n_size) const {
+      return !racy && mtime == n_mtime && fsize == n_size;
+   }
+
    DLLLOCAL virtual ~QoreUserModule();
 
    DLLLOCAL virtual bool isBuiltin() const {
@@ -0,0 +1,103 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QC_StringBuilder.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_CLASS_STRINGBUILDER_H
+#define _QORE_CLASS_STRINGBUILDER_H
+
+#include <qore/AbstractPrivateData.h>
+
+DLLEXPORT extern qore_classid_t CID_STRINGBUILDER;
+DLLLOCAL extern QoreClass* QC_STRINGBUILDER;
+DLLLOCAL QoreClass* initStringBuilderClass(QoreNamespace& ns);
+
+/**
+ * @brief Private data for the Qore::StringBuilder class.
+ *
+ * Holds a single string buffer that grows geometrically; the buffer is handed over to the
+ * string returned by take() without copying
+ */
+class StringBuilderData : public AbstractPrivateData {
+public:
+   DLLLOCAL StringBuilderData(const QoreEncoding* enc, size_t size = 0) : str(enc) {
+      if (size)
+         str.reserve(size);
+   }
+
+   DLLLOCAL int concat(const QoreString* s, ExceptionSink* xsink) {
+      AutoLocker al(m);
+      str.concat(s, xsink);
+      return *xsink ? -1 : 0;
+   }
+
+   DLLLOCAL void reserve(size_t size) {
+      AutoLocker al(m);
+      str.reserve(size);
+   }
+
+   DLLLOCAL size_t size() const {
+      AutoLocker al(m);
+      return str.size();
+   }
+
+   DLLLOCAL size_t capacity() const {
+      AutoLocker al(m);
+      return str.capacity();
+   }
+
+   DLLLOCAL void clear() {
+      AutoLocker al(m);
+      str.clear();
+   }
+
+   //! returns a copy of the string
+   DLLLOCAL QoreStringNode* toString() const {
+      AutoLocker al(m);
+      return new QoreStringNode(str);
+   }
+
+   //! returns the string and clears the builder; the buffer is transferred without copying
+   DLLLOCAL QoreStringNode* take() {
+      AutoLocker al(m);
+      const QoreEncoding* enc = str.getEncoding();
+      size_t len = str.size();
+      size_t allocated = str.capacity();
+      char* buf = str.giveBuffer();
+      str.reset();
+      str.setEncoding(enc);
+      return buf ? new QoreStringNode(buf, len, allocated, enc) : new QoreStringNode(enc);
+   }
+
+protected:
+   QoreString str;
+   mutable QoreThreadLock m;
+};
+
+#endif
@@ -1817,7 +1817,8 @@ public:
       pub : 1,                          // is a public class (modules only)
       final : 1,                        // is the class "final" (cannot be inherited)
       inject : 1,                       // has the class been injected
-      gate_access : 1                   // if the methodGate and memberGate methods should be called with a class access boolean
+      gate_access : 1,                  // if the methodGate and memberGate methods should be called with a class access boolean
+      shared : 1                        // is the class referenced by Programs importing its user module (not copied)
       ;
 
    int64 domain;                    // capabilities of builtin class to use in the context of parse restrictions
@@ -1873,6 +1874,19 @@ public:
       return !ahm.empty();
    }
 
+   // returns true if the class or any of its parent classes has static variables
+   DLLLOCAL bool hasStaticVarsInHierarchy() const {
+      if (!vars.empty() || !pending_vars.empty())
+         return true;
+      if (scl) {
+         for (auto& i : *scl) {
+            if ((*i).sclass && (*i).sclass->priv->hasStaticVarsInHierarchy())
+               return true;
+         }
+      }
+      return false;
+   }
+
    DLLLOCAL int runtimeCheckInstantiateClass(ExceptionSink* xsink) const {
       return ahm.runtimeCheckInstantiateClass(name.c_str(), xsink);
    }
@@ -41,6 +41,7 @@
 #include <stdlib.h>
 
 #include <map>
+#include <set>
 
 #ifdef HAVE_QORE_HASH_MAP
 //#warning compiling with hash_map
@@ -64,6 +65,9 @@ class QoreClassList {
 private:
    hm_qc_t hm;        // hash_map for name lookups
 
+   typedef std::set<const QoreClass*> qc_set_t;
+   qc_set_t shared;   // classes referenced from a user module's Program; not parsed or cleared here
+
    DLLLOCAL void deleteAll();
    DLLLOCAL void assimilate(QoreClassList& n);
 
@@ -76,7 +80,8 @@ public:
    DLLLOCAL ~QoreClassList();
    DLLLOCAL QoreClassList(const QoreClassList& old, int64 po, qore_ns_private* ns);
 
-   DLLLOCAL void mergeUserPublic(const QoreClassList& old, qore_ns_private* ns);
+   // if share is true, then classes without static variables in their hierarchy are referenced instead of copied
+   DLLLOCAL void mergeUserPublic(const QoreClassList& old, qore_ns_private* ns, bool share = false);
 
    // returns the number of classes imported
    DLLLOCAL int importSystemClasses(const QoreClassList& source, qore_ns_private* ns, ExceptionSink* xsink);
@@ -101,6 +106,11 @@ public:
       return hm.empty();
    }
 
+   // returns true if the class is referenced from the Program of a user module
+   DLLLOCAL bool isShared(const QoreClass* qc) const {
+      return !shared.empty() && shared.find(qc) != shared.end();
+   }
+
    DLLLOCAL void clear(ExceptionSink* xsink);
    DLLLOCAL void clearConstants(QoreListNode& l);
    DLLLOCAL void deleteClassData(ExceptionSink* xsink);
@@ -108,11 +118,12 @@ public:
 
 class ClassListIterator {
 protected:
+   QoreClassList& ql;
    hm_qc_t& cl;
    hm_qc_t::iterator i;
 
 public:
-   DLLLOCAL ClassListIterator(QoreClassList& n_cl) : cl(n_cl.hm), i(cl.end()) {
+   DLLLOCAL ClassListIterator(QoreClassList& n_cl) : ql(n_cl), cl(n_cl.hm), i(cl.end()) {
    }
 
    DLLLOCAL bool next() {
@@ -138,11 +149,12 @@ public:
 
 class ConstClassListIterator {
 protected:
+   const QoreClassList& ql;
    const hm_qc_t& cl;
    hm_qc_t::const_iterator i;
 
 public:
-   DLLLOCAL ConstClassListIterator(const QoreClassList& n_cl) : cl(n_cl.hm), i(cl.end()) {
+   DLLLOCAL ConstClassListIterator(const QoreClassList& n_cl) : ql(n_cl), cl(n_cl.hm), i(cl.end()) {
    }
 
    DLLLOCAL bool next() {
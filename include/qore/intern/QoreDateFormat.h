@@ -0,0 +1,94 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreDateFormat.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_QOREDATEFORMAT_H
+#define _QORE_QOREDATEFORMAT_H
+
+#include <string>
+#include <vector>
+
+struct qore_time_info;
+
+/**
+ * @brief A date format string or date mask compiled into a sequence of operations.
+ *
+ * The same mask string is compiled once for output (see @ref date_formatting) and once for input
+ * (see @ref date_mask) so that neither has to be interpreted character by character on every call.
+ */
+class QoreDateFormat {
+public:
+   DLLLOCAL QoreDateFormat(const char* n_mask, size_t len);
+
+   //! appends the formatted date to the string
+   DLLLOCAL void format(QoreString& str, const qore_time_info& i) const;
+
+   //! appends the formatted date to the string
+   DLLLOCAL void format(QoreString& str, const DateTime& dt) const;
+
+   //! parses the string according to the mask and returns the date in the given time zone
+   DLLLOCAL DateTimeNode* parse(const QoreString& dtstr, const AbstractQoreZoneInfo* tz, ExceptionSink* xsink) const;
+
+   DLLLOCAL const std::string& getMask() const {
+      return mask;
+   }
+
+   //! returns the compiled format for the given mask from the current thread's format cache
+   /** the reference returned is only valid until the next call to this function in the same thread
+    */
+   DLLLOCAL static const QoreDateFormat& get(const char* mask, size_t len);
+
+   //! deletes all compiled formats in the current thread's format cache
+   DLLLOCAL static void clearThreadCache();
+
+protected:
+   // a single compiled operation
+   struct op_t {
+      unsigned char code;
+      // literal offset and length in the mask for output literals, or the number of bytes skipped for input
+      unsigned off, len;
+
+      DLLLOCAL op_t(unsigned char n_code, unsigned n_off = 0, unsigned n_len = 0) : code(n_code), off(n_off), len(n_len) {
+      }
+   };
+   typedef std::vector<op_t> op_list_t;
+
+   // the original mask
+   std::string mask;
+   // output operations
+   op_list_t fops;
+   // input operations
+   op_list_t pops;
+
+   DLLLOCAL void compileFormat();
+   DLLLOCAL void compileParse();
+};
+
+#endif
@@ -0,0 +1,127 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreDnsCache.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_QOREDNSCACHE_H
+#define _QORE_QOREDNSCACHE_H
+
+#include <qore/QoreThreadLock.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+// default time to live for successful lookups in milliseconds
+#define QORE_DNS_CACHE_TTL 60000
+// default time to live for failed lookups in milliseconds
+#define QORE_DNS_CACHE_NEGATIVE_TTL 5000
+// default maximum number of cache entries
+#define QORE_DNS_CACHE_MAX 1024
+
+//! the result of a single address lookup
+class QoreDnsEntry {
+public:
+   // the addresses found; 0 if the lookup failed
+   struct addrinfo* ai;
+   // the getaddrinfo() return code
+   int status;
+   // expiry time in milliseconds
+   int64 expires;
+
+   DLLLOCAL QoreDnsEntry(struct addrinfo* n_ai, int n_status, int64 n_expires) : ai(n_ai), status(n_status), expires(n_expires) {
+   }
+
+   DLLLOCAL ~QoreDnsEntry() {
+      if (ai)
+         freeaddrinfo(ai);
+   }
+
+private:
+   // not implemented
+   DLLLOCAL QoreDnsEntry(const QoreDnsEntry&);
+   DLLLOCAL QoreDnsEntry& operator=(const QoreDnsEntry&);
+};
+
+typedef std::shared_ptr<QoreDnsEntry> dns_entry_t;
+
+/**
+ * @brief A process-wide cache of getaddrinfo() results.
+ *
+ * Successful lookups are cached for the positive TTL; lookups that fail because the name does not exist are cached
+ * for the negative TTL, while temporary failures are not cached at all.  Entries are shared, so results can be used
+ * after they have been removed from the cache.
+ */
+class QoreDnsCache {
+public:
+   //! returns the cached result of the lookup or resolves it; raises an exception if the lookup failed
+   DLLLOCAL dns_entry_t get(ExceptionSink* xsink, const char* node, const char* service, int family = Q_AF_UNSPEC, int flags = 0, int socktype = Q_SOCK_STREAM, int protocol = 0);
+
+   //! resolves the name bypassing any cached entry and stores the result in the cache
+   DLLLOCAL dns_entry_t resolve(const char* node, const char* service, int family = Q_AF_UNSPEC, int flags = 0, int socktype = Q_SOCK_STREAM, int protocol = 0);
+
+   //! sets cache options from a hash with optional "ttl", "negative_ttl", and "max" keys
+   DLLLOCAL int setOptions(const QoreHashNode* opts, ExceptionSink* xsink);
+
+   //! returns cache options and statistics
+   DLLLOCAL QoreHashNode* getInfo() const;
+
+   //! removes all entries
+   DLLLOCAL void clear();
+
+   //! raises an exception for a failed lookup
+   DLLLOCAL static void raiseError(ExceptionSink* xsink, int status, const char* node, const char* service, int family, int flags);
+
+protected:
+   typedef std::map<std::string, dns_entry_t> dns_map_t;
+
+   mutable QoreThreadLock l;
+   dns_map_t dmap;
+
+   int64 ttl = QORE_DNS_CACHE_TTL,
+      negative_ttl = QORE_DNS_CACHE_NEGATIVE_TTL;
+   size_t max = QORE_DNS_CACHE_MAX;
+
+   // statistics
+   int64 hits = 0,
+      misses = 0,
+      negative_hits = 0;
+
+   DLLLOCAL static std::string getKey(const char* node, const char* service, int family, int flags, int socktype, int protocol);
+
+   // stores the entry in the cache; must be called with the lock held
+   DLLLOCAL void store(const std::string& key, const dns_entry_t& e, int64 now);
+};
+
+DLLLOCAL extern QoreDnsCache QDC;
+
+//! returns a list of address information hashes for the given addresses
+DLLLOCAL QoreListNode* q_addrinfo_to_list(const struct addrinfo* ai, bool has_svc);
+
+#endif
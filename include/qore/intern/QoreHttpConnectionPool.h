@@ -0,0 +1,148 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreHttpConnectionPool.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_QOREHTTPCONNECTIONPOOL_H
+#define _QORE_QOREHTTPCONNECTIONPOOL_H
+
+#include <qore/AbstractPrivateData.h>
+#include <qore/QoreThreadLock.h>
+#include <qore/QoreCondition.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+class QoreSSLContext;
+
+/**
+ * @brief Private data for the Qore::HTTPConnectionPool class.
+ *
+ * Keeps persistent HTTPClient objects per target (scheme, user info, host and port) so that requests to the same
+ * host can reuse open connections; objects of this class are thread safe.
+ */
+class QoreHttpConnectionPool : public AbstractPrivateData {
+public:
+   DLLLOCAL QoreHttpConnectionPool(const QoreHashNode* opts, ExceptionSink* xsink);
+
+   DLLLOCAL virtual void deref(ExceptionSink* xsink) {
+      if (ROdereference()) {
+         destructor(xsink);
+         delete this;
+      }
+   }
+
+   //! leases an HTTPClient object for the target of the given URL; the caller owns the reference returned
+   /** if the URL has a path, it is returned in \a path
+    */
+   DLLLOCAL QoreObject* get(const QoreString& url, int timeout_ms, std::string& path, ExceptionSink* xsink);
+
+   //! returns a leased HTTPClient object to the pool; if \a discard is true, the object is removed from the pool
+   DLLLOCAL int release(QoreObject* obj, bool discard, ExceptionSink* xsink);
+
+   //! closes and removes all idle connections from the pool
+   DLLLOCAL void clear(ExceptionSink* xsink);
+
+   //! returns pool statistics
+   DLLLOCAL QoreHashNode* getStats() const;
+
+   //! marks the pool as invalid, wakes up any waiting threads and releases all objects held by the pool
+   DLLLOCAL void destructor(ExceptionSink* xsink);
+
+protected:
+   // an idle connection
+   struct idle_conn_t {
+      QoreObject* obj;
+      // the time the connection was returned to the pool in microseconds
+      int64 time_us;
+   };
+   typedef std::deque<idle_conn_t> idle_list_t;
+
+   // connections for a single target
+   struct host_pool_t {
+      // idle connections; the most recently used connection is at the front
+      idle_list_t idle;
+      // number of leased connections
+      unsigned in_use = 0;
+      // number of threads waiting on a connection
+      unsigned waiting = 0;
+      // the target with any password masked for statistics and error messages
+      std::string desc;
+   };
+   typedef std::map<std::string, host_pool_t> host_map_t;
+   // leased objects -> target
+   typedef std::map<QoreObject*, std::string> leased_map_t;
+   typedef std::vector<QoreObject*> obj_list_t;
+
+   mutable QoreThreadLock l;
+   QoreCondition cond;
+   host_map_t hmap;
+   leased_map_t leased;
+
+   // options for new HTTPClient objects
+   QoreHashNode* client_opts = nullptr;
+   // optional shared TLS/SSL context for new HTTPClient objects
+   QoreSSLContext* ssl_ctx = nullptr;
+
+   // maximum number of connections per target
+   unsigned max = 10;
+   // maximum number of idle connections per target
+   unsigned max_idle = 10;
+   // minimum number of idle connections per target that are not closed when they expire
+   unsigned min_idle = 0;
+   // idle connection timeout in milliseconds; 0 = never expire
+   int64 idle_timeout_ms = 60000;
+   bool valid = true;
+
+   // statistics
+   int64 created = 0, reused = 0, closed = 0, stale = 0, waits = 0, timeouts = 0;
+
+   DLLLOCAL virtual ~QoreHttpConnectionPool();
+
+   // leases an object for the given target; objects to be closed are added to the list
+   DLLLOCAL QoreObject* getIntern(const std::string& target, const std::string& desc, int timeout_ms, obj_list_t& ol, ExceptionSink* xsink);
+
+   // creates a new HTTPClient object for the given target; called without the lock held
+   DLLLOCAL QoreObject* create(const std::string& target, ExceptionSink* xsink);
+
+   // moves expired idle connections to the given list; must be called with the lock held
+   DLLLOCAL void expire(host_pool_t& hp, int64 now_us, obj_list_t& ol);
+
+   // dereferences and closes all objects in the list; must be called without the lock held
+   DLLLOCAL void close(obj_list_t& ol, ExceptionSink* xsink);
+
+private:
+   // not implemented
+   DLLLOCAL QoreHttpConnectionPool(const QoreHttpConnectionPool&);
+   DLLLOCAL QoreHttpConnectionPool& operator=(const QoreHttpConnectionPool&);
+};
+
+#endif
@@ -424,7 +424,8 @@ public:
    }
 
    DLLLOCAL void scanMergeCommittedNamespace(const qore_ns_private& mns, QoreModuleContext& qmc) const;
-   DLLLOCAL void copyMergeCommittedNamespace(const qore_ns_private& mns);
+   // if share is true, then immutable user classes are referenced instead of copied
+   DLLLOCAL void copyMergeCommittedNamespace(const qore_ns_private& mns, bool share = false);
 
    DLLLOCAL void parseInitGlobalVars();
 
@@ -1960,8 +1961,8 @@ public:
       ns.priv->scanMergeCommittedNamespace(*(mns.priv), qmc);
    }
 
-   DLLLOCAL static void copyMergeCommittedNamespace(RootQoreNamespace& ns, const RootQoreNamespace& mns) {
-      ns.priv->copyMergeCommittedNamespace(*(mns.priv));
+   DLLLOCAL static void copyMergeCommittedNamespace(RootQoreNamespace& ns, const RootQoreNamespace& mns, bool share = false) {
+      ns.priv->copyMergeCommittedNamespace(*(mns.priv), share);
 
       // rebuild root indexes - only for committed objects
       ns.rpriv->rebuildAllIndexes();
@@ -35,6 +35,11 @@
 
 class QorePlusOperatorNode : public QoreBinaryOperatorNode<> {
 protected:
+   // type of pointer to optimized versions depending on arguments found at parse-time
+   typedef QoreValue(QorePlusOperatorNode::*eval_t)(ExceptionSink* xsink) const;
+   // pointer to optimized versions depending on arguments found at parse-time
+   eval_t pfunc;
+
    const QoreTypeInfo* returnTypeInfo;
 
    DLLLOCAL static QoreString plus_str;
@@ -43,8 +48,11 @@ protected:
 
    DLLLOCAL virtual AbstractQoreNode* parseInitImpl(LocalVar* oflag, int pflag, int& lvids, const QoreTypeInfo*& typeInfo);
 
+   DLLLOCAL QoreValue floatPlus(ExceptionSink* xsink) const;
+   DLLLOCAL QoreValue bigIntPlus(ExceptionSink* xsink) const;
+
 public:
-   DLLLOCAL QorePlusOperatorNode(const QoreProgramLocation& loc, AbstractQoreNode* n_left, AbstractQoreNode* n_right) : QoreBinaryOperatorNode<>(loc, n_left, n_right), returnTypeInfo(nullptr) {
+   DLLLOCAL QorePlusOperatorNode(const QoreProgramLocation& loc, AbstractQoreNode* n_left, AbstractQoreNode* n_right) : QoreBinaryOperatorNode<>(loc, n_left, n_right), pfunc(nullptr), returnTypeInfo(nullptr) {
    }
 
    DLLLOCAL virtual QoreString* getAsString(bool& del, int foff, ExceptionSink* xsink) const {
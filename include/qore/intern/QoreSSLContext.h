@@ -0,0 +1,91 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreSSLContext.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_QORESSLCONTEXT_H
+#define _QORE_QORESSLCONTEXT_H
+
+#include <qore/AbstractPrivateData.h>
+#include <qore/QoreThreadLock.h>
+
+#include <openssl/ssl.h>
+
+#include <map>
+#include <string>
+
+/**
+ * @brief A TLS/SSL context shared by any number of sockets.
+ *
+ * The certificate and private key are loaded into the context once; client connections made with the context
+ * store their sessions by peer address so that later connections to the same peer can resume them, and server
+ * connections use the OpenSSL internal session cache and session tickets.
+ */
+class QoreSSLContext : public AbstractPrivateData {
+public:
+   DLLLOCAL QoreSSLContext(X509* cert, EVP_PKEY* pk, int cache_size, ExceptionSink* xsink);
+
+   DLLLOCAL SSL_CTX* getContext() const {
+      return ctx;
+   }
+
+   //! sets a cached client session for the given peer on the SSL object, if any
+   DLLLOCAL void setClientSession(SSL* ssl, const std::string& peer);
+
+   //! stores a new client session for the given peer; takes over the reference to the session
+   DLLLOCAL void addClientSession(const std::string& peer, SSL_SESSION* sess);
+
+   //! removes all cached sessions
+   DLLLOCAL void clearSessions();
+
+   //! returns session cache statistics
+   DLLLOCAL QoreHashNode* getStats() const;
+
+protected:
+   typedef std::map<std::string, SSL_SESSION*> session_map_t;
+
+   SSL_CTX* ctx = nullptr;
+   mutable QoreThreadLock l;
+   // client sessions by peer address
+   session_map_t cmap;
+   // maximum number of client sessions
+   size_t max_client;
+
+   DLLLOCAL virtual ~QoreSSLContext();
+
+   // must be called with the lock held
+   DLLLOCAL void clearClientSessions();
+
+private:
+   // not implemented
+   DLLLOCAL QoreSSLContext(const QoreSSLContext&);
+   DLLLOCAL QoreSSLContext& operator=(const QoreSSLContext&);
+};
+
+#endif
@@ -0,0 +1,132 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreSocketPollSet.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_QORESOCKETPOLLSET_H
+#define _QORE_QORESOCKETPOLLSET_H
+
+#include <qore/AbstractPrivateData.h>
+#include <qore/QoreThreadLock.h>
+
+#include <map>
+
+// readiness event flags
+#define SOCK_POLLIN (1 << 0)
+#define SOCK_POLLOUT (1 << 1)
+#define SOCK_POLLERR (1 << 2)
+
+// epoll is used where available; otherwise the set is polled with poll(2)
+#if defined HAVE_SYS_EPOLL_H && defined HAVE_EPOLL_CREATE1
+#define QORE_USE_EPOLL 1
+#endif
+
+class QoreSocketObject;
+
+/**
+ * @brief Private data for the Qore::SocketPollSet class.
+ *
+ * Registers any number of Socket objects for read and write readiness and returns the ready sockets in a single
+ * call.  Sockets with data already buffered in the socket read buffer or in the TLS/SSL layer are reported as
+ * readable without waiting, since the kernel does not know about this data.
+ */
+class QoreSocketPollSet : public AbstractPrivateData {
+public:
+   DLLLOCAL QoreSocketPollSet(bool n_edge, ExceptionSink* xsink);
+
+   DLLLOCAL virtual void deref(ExceptionSink* xsink) {
+      if (ROdereference()) {
+         clear(xsink);
+         delete this;
+      }
+   }
+
+   //! registers the socket for the given events; the socket must be open
+   DLLLOCAL int add(QoreObject* obj, QoreSocketObject* sock, int events, const QoreValue arg, ExceptionSink* xsink);
+
+   //! changes the events for a registered socket
+   DLLLOCAL int modify(QoreObject* obj, int events, ExceptionSink* xsink);
+
+   //! removes the socket from the set; returns true if the socket was registered
+   DLLLOCAL bool remove(QoreObject* obj, ExceptionSink* xsink);
+
+   //! waits for readiness events and returns a list of hashes for the ready sockets
+   DLLLOCAL QoreListNode* wait(int timeout_ms, int max_events, ExceptionSink* xsink);
+
+   //! removes all sockets from the set
+   DLLLOCAL void clear(ExceptionSink* xsink);
+
+   DLLLOCAL size_t size() const;
+
+   DLLLOCAL bool edgeTriggered() const {
+      return edge;
+   }
+
+protected:
+   // a registered socket
+   struct poll_entry_t {
+      QoreObject* obj;
+      QoreSocketObject* sock;
+      // the descriptor registered
+      int fd;
+      int events;
+      // the value returned with events for the socket
+      QoreValue arg;
+   };
+   // registered sockets by descriptor
+   typedef std::map<int, poll_entry_t> poll_map_t;
+
+   mutable QoreThreadLock l;
+   poll_map_t pmap;
+   bool edge;
+#ifdef QORE_USE_EPOLL
+   int epfd = -1;
+#endif
+
+   DLLLOCAL virtual ~QoreSocketPollSet();
+
+   // returns the entry for the given object; must be called with the lock held
+   DLLLOCAL poll_map_t::iterator find(QoreObject* obj);
+
+   // updates the kernel registration for the descriptor
+   DLLLOCAL int ctl(int op, int fd, int events, ExceptionSink* xsink);
+
+   // releases the references held by the entry; must be called without the lock held
+   DLLLOCAL static void del(poll_entry_t& e, ExceptionSink* xsink);
+
+   // returns a hash describing a ready socket
+   DLLLOCAL static QoreHashNode* getEvent(const poll_entry_t& e, int revents);
+
+private:
+   // not implemented
+   DLLLOCAL QoreSocketPollSet(const QoreSocketPollSet&);
+   DLLLOCAL QoreSocketPollSet& operator=(const QoreSocketPollSet&);
+};
+
+#endif
@@ -33,10 +33,13 @@
 
 #define _QORE_QORETHREADLIST_H
 
+#include <atomic>
+
 // FIXME: move to config.h or something like that
-// not more than this number of threads can be running at the same time
+// not more than this number of threads can be running at the same time; thread entries are allocated
+// on demand, so this only limits the maximum size of the thread table
 #ifndef MAX_QORE_THREADS
-#define MAX_QORE_THREADS 0x1000
+#define MAX_QORE_THREADS 0x10000
 #endif
 
 class ThreadData;
@@ -77,14 +80,16 @@ public:
    CallStack* callStack;
 #endif
    ThreadData* thread_data;
+   // the next TID in the free list; only valid if the entry is in the free list
+   int next_free;
    unsigned char status;
-   bool joined; // if set to true then pthread_detach should not be called on exit
+   bool joined; // if set to true then pthread_detach should not be called on exit (also set for threads that detach themselves)
 
    DLLLOCAL void cleanup();
 
    DLLLOCAL void allocate(tid_node* tn, int stat = QTS_NA);
 
-   DLLLOCAL void activate(int tid, pthread_t n_ptid, QoreProgram* p, bool foreign = false);
+   DLLLOCAL void activate(int tid, pthread_t n_ptid, QoreProgram* p, bool foreign = false, bool detached = false);
 
    DLLLOCAL bool active() const {
       return status == QTS_ACTIVE;
@@ -99,50 +104,90 @@ class QoreThreadList {
 friend class QoreThreadListIterator;
 friend class tid_node;
 protected:
+   // thread entries are allocated in blocks that are never moved or freed, so an entry can be accessed
+   // by its thread without holding the lock
+   static constexpr unsigned QTL_BLOCK_SIZE = 1024;
+   static constexpr unsigned QTL_NUM_BLOCKS = (MAX_QORE_THREADS + QTL_BLOCK_SIZE - 1) / QTL_BLOCK_SIZE;
+
    mutable QoreThreadLock l;
    unsigned num_threads;
-   ThreadEntry entry[MAX_QORE_THREADS];
+   ThreadEntry* block[QTL_NUM_BLOCKS];
 
    tid_node* tid_head, * tid_tail;
 
-   // current TID to be issued next
-   int current_tid;
+   // current TID to be issued next; only modified with the lock held, but read without it in entry()
+   std::atomic<int> current_tid;
+
+   // FIFO list of released TIDs, linked through ThreadEntry::next_free
+   int free_head, free_tail;
 
    bool exiting;
 
+   DLLLOCAL ThreadEntry& entry(int tid) const {
+      assert(tid >= 0 && tid < current_tid.load(std::memory_order_relaxed));
+      return block[tid / QTL_BLOCK_SIZE][tid % QTL_BLOCK_SIZE];
+   }
+
    DLLLOCAL void releaseIntern(int tid) {
       // NOTE: cannot safely call printd here, because normally the thread_data has been deleted
       //printf("DEBUG: ThreadList.releaseIntern() TID %d terminated\n", tid);
-      entry[tid].cleanup();
-      if (tid)
+      ThreadEntry& e = entry(tid);
+      e.cleanup();
+      if (tid) {
          --num_threads;
+
+         // add the TID to the free list
+         e.next_free = -1;
+         if (free_tail == -1)
+            free_head = tid;
+         else
+            entry(free_tail).next_free = tid;
+         free_tail = tid;
+      }
+   }
+
+   // returns the next TID to issue or -1 if the thread table is full; must be called with the lock held
+   DLLLOCAL int getTidIntern() {
+      // issue new TIDs as long as they are in an allocated block
+      if (current_tid < MAX_QORE_THREADS && current_tid % QTL_BLOCK_SIZE)
+         return current_tid++;
+
+      // otherwise reuse released TIDs before allocating a new block
+      if (free_head != -1) {
+         int tid = free_head;
+         free_head = entry(tid).next_free;
+         if (free_head == -1)
+            free_tail = -1;
+         return tid;
+      }
+
+      if (current_tid == MAX_QORE_THREADS)
+         return -1;
+      ThreadEntry*& b = block[current_tid / QTL_BLOCK_SIZE];
+      if (!b)
+         b = new ThreadEntry[QTL_BLOCK_SIZE]();
+      return current_tid++;
    }
 
 public:
-   DLLLOCAL QoreThreadList() : num_threads(0), tid_head(0), tid_tail(0), current_tid(1), exiting(false) {
+   DLLLOCAL QoreThreadList() : num_threads(0), block(), tid_head(0), tid_tail(0), current_tid(1), free_head(-1), free_tail(-1), exiting(false) {
+      // the first block is always present for the signal thread entry (TID 0)
+      block[0] = new ThreadEntry[QTL_BLOCK_SIZE]();
+   }
+
+   DLLLOCAL ~QoreThreadList() {
+      for (unsigned i = 0; i < QTL_NUM_BLOCKS; ++i)
+         delete [] block[i];
    }
 
    DLLLOCAL int get(int status = QTS_NA) {
-      int tid = -1;
       AutoLocker al(l);
 
-      if (current_tid == MAX_QORE_THREADS) {
-         int i;
-         // scan thread_list for free entry
-         for (i = 1; i < MAX_QORE_THREADS; i++) {
-            if (entry[i].available()) {
-               tid = i;
-               goto finish;
-            }
-         }
-         if (i == MAX_QORE_THREADS)
-            return -1;
-      }
-      else
-         tid = current_tid++;
+      int tid = getTidIntern();
+      if (tid == -1)
+         return -1;
 
-   finish:
-      entry[tid].allocate(new tid_node(tid), status);
+      entry(tid).allocate(new tid_node(tid), status);
       ++num_threads;
       //printf("t%d cs=0\n", tid);
 
@@ -151,7 +196,7 @@ public:
 
    DLLLOCAL int getSignalThreadEntry() {
       AutoLocker al(l);
-      entry[0].allocate(0);
+      entry(0).allocate(0);
       return 0;
    }
 
@@ -162,22 +207,23 @@ public:
 
    DLLLOCAL int releaseReserved(int tid) {
       AutoLocker al(l);
-      if (entry[tid].status != QTS_RESERVED)
+      if (tid >= current_tid || entry(tid).status != QTS_RESERVED)
          return -1;
 
       releaseIntern(tid);
       return 0;
    }
 
-   DLLLOCAL void activate(int tid, pthread_t ptid = pthread_self(), QoreProgram* p = 0, bool foreign = false) {
+   DLLLOCAL void activate(int tid, pthread_t ptid = pthread_self(), QoreProgram* p = 0, bool foreign = false, bool detached = false) {
       AutoLocker al(l);
-      entry[tid].activate(tid, ptid, p, foreign);
+      entry(tid).activate(tid, ptid, p, foreign, detached);
    }
 
    DLLLOCAL void setStatus(int tid, int status) {
       AutoLocker al(l);
-      assert(entry[tid].status != status);
-      entry[tid].status = status;
+      ThreadEntry& e = entry(tid);
+      assert(e.status != status);
+      e.status = status;
    }
 
    DLLLOCAL void deleteData(int tid);
@@ -189,10 +235,10 @@ public:
    DLLLOCAL int activateReserved(int tid) {
       AutoLocker al(l);
 
-      if (entry[tid].status != QTS_RESERVED)
+      if (tid >= current_tid || entry(tid).status != QTS_RESERVED)
          return -1;
 
-      entry[tid].activate(tid, pthread_self(), 0, true);
+      entry(tid).activate(tid, pthread_self(), 0, true);
       return 0;
    }
 
@@ -212,7 +258,7 @@ public:
    DLLLOCAL QoreListNode* getCallStackList();
 
    DLLLOCAL CallStack* getCallStack() {
-      return entry[gettid()].callStack;
+      return entry(gettid()).callStack;
    }
 #endif
 
@@ -231,7 +277,7 @@ public:
    DLLLOCAL bool next() {
       do {
          w = w ? w->next : thread_list.tid_head;
-      } while (w && (!w->tid || (thread_list.entry[w->tid].status != QTS_ACTIVE)));
+      } while (w && (!w->tid || (thread_list.entry(w->tid).status != QTS_ACTIVE)));
 
       return (bool)w;
    }
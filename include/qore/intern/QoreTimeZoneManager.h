@@ -182,12 +182,10 @@ public:
 
 class QoreZoneInfo : public AbstractQoreZoneInfo {
 protected:
-   // first positive transition entry (after the epoch)
-   int first_pos;
    bool valid;
    const char *std_abbr;  // standard time abbreviation
 
-   // QoreDSTTransition times
+   // QoreDSTTransition times, sorted ascending
    typedef std::vector<QoreDSTTransition> dst_transition_vec_t;
    dst_transition_vec_t QoreDSTTransitions;
 
@@ -214,6 +212,9 @@ public:
    DLLLOCAL const trans_vec_t &getTransitionList() const {
       return tti;
    }
+
+   // clears the current thread's cache of the last transition interval found
+   DLLLOCAL static void clearThreadCache();
 };
 
 #ifdef _Q_WINDOWS
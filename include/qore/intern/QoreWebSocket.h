@@ -0,0 +1,62 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreWebSocket.h
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#ifndef _QORE_QOREWEBSOCKET_H
+#define _QORE_QOREWEBSOCKET_H
+
+// RFC 6455 frame header bits
+#define QORE_WS_FIN    0x80
+#define QORE_WS_MASKED 0x80
+
+// RFC 6455 opcodes
+#define QORE_WSOP_CONTINUATION 0x0
+#define QORE_WSOP_TEXT         0x1
+#define QORE_WSOP_BINARY       0x2
+#define QORE_WSOP_CLOSE        0x8
+#define QORE_WSOP_PING         0x9
+#define QORE_WSOP_PONG         0xa
+
+// close code used when a close frame has no status code
+#define QORE_WSCC_NO_STATUS_RCVD 1005
+
+// the maximum size of a frame header: 2 bytes + 8 bytes extended length + 4 bytes mask
+#define QORE_WS_MAX_HEADER 14
+
+//! XORs len bytes from src with the 4-byte mask and writes the result to dst; dst may be the same as src
+DLLLOCAL void q_ws_mask(unsigned char* dst, const unsigned char* src, size_t len, const unsigned char* mask);
+
+//! writes a frame header for a payload of len bytes to hdr and returns the size of the header; mask may be 0
+DLLLOCAL size_t q_ws_encode_header(unsigned char* hdr, int op, bool fin, size_t len, const unsigned char* mask);
+
+//! returns a new frame with the given payload; the payload is masked with a random mask if masked is true
+DLLLOCAL BinaryNode* q_ws_encode_frame(const void* data, size_t len, int op, bool fin, bool masked);
+
+#endif
@@ -41,7 +41,10 @@
 #define SSL_METHOD_CONST
 #endif
 
+#include <string>
+
 struct qore_socket_private;
+class QoreSSLContext;
 
 class SSLSocketHelper {
 private:
@@ -49,6 +52,10 @@ private:
    SSL_METHOD_CONST SSL_METHOD* meth;
    SSL_CTX* ctx;
    SSL* ssl;
+   // shared context, if any; in this case ctx is not set
+   QoreSSLContext* sctx = nullptr;
+   // the server name and peer address for client sessions with a shared context
+   std::string peer;
    unsigned refs;
 
    DLLLOCAL int setIntern(const char* meth, int sd, X509* cert, EVP_PKEY* pk, ExceptionSink* xsink);
@@ -56,12 +63,7 @@ private:
    // non-blocking I/O helper
    DLLLOCAL int doSSLUpgradeNonBlockingIO(int rc, const char* mname, int timeout_ms, const char* ssl_func, ExceptionSink* xsink);
 
-   DLLLOCAL ~SSLSocketHelper() {
-      if (ssl)
-         SSL_free(ssl);
-      if (ctx)
-         SSL_CTX_free(ctx);
-   }
+   DLLLOCAL ~SSLSocketHelper();
 
    // must be called with refs > 1
    DLLLOCAL bool sslError(ExceptionSink* xsink, const char* meth, const char* msg, bool always_error = true);
@@ -105,6 +107,9 @@ public:
    DLLLOCAL const char* getCipherVersion() const;
    DLLLOCAL X509* getPeerCertificate() const;
    DLLLOCAL long verifyPeerCertificate() const;
+   DLLLOCAL bool sessionReused() const;
+   // returns the number of decrypted bytes buffered in the TLS/SSL layer
+   DLLLOCAL int pending() const;
 
    DLLLOCAL void setVerifyMode(int mode, bool accept_all_certs);
 };
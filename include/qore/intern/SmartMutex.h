@@ -50,6 +50,8 @@ private:
    DLLLOCAL virtual int tryGrabImpl(int mtid, VLock *nvl);
    DLLLOCAL virtual int externWaitImpl(int mtid, QoreCondition *cond, ExceptionSink *xsink, int64 timeout = 0);
    DLLLOCAL virtual void destructorImpl(ExceptionSink *xsink);
+   DLLLOCAL virtual bool grabFastImpl(int mtid, int& rc);
+   DLLLOCAL virtual bool releaseFastImpl(int mtid, int& rc);
    
 public:
    DLLLOCAL SmartMutex() {}
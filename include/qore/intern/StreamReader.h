@@ -122,7 +122,7 @@ public:
       return eol ? readLineEol(eol, trim, xsink) : readLine(trim, xsink);
    }
 
-   DLLLOCAL QoreStringNode* readLineEol(const QoreString* eol, bool trim, ExceptionSink* xsink) {
+   DLLLOCAL virtual QoreStringNode* readLineEol(const QoreString* eol, bool trim, ExceptionSink* xsink) {
       TempEncodingHelper eolstr(eol, enc, xsink);
       if (*xsink)
          return 0;
@@ -171,7 +171,7 @@ public:
       }
    }
 
-   DLLLOCAL QoreStringNode* readLine(bool trim, ExceptionSink* xsink) {
+   DLLLOCAL virtual QoreStringNode* readLine(bool trim, ExceptionSink* xsink) {
       SimpleRefHolder<QoreStringNode> str(new QoreStringNode(enc));
 
       while (true) {
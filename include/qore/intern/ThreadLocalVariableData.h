@@ -32,8 +32,15 @@
 #ifndef _QORE_INTERN_THREADLOCALVARIABLEDATA_H
 #define _QORE_INTERN_THREADLOCALVARIABLEDATA_H
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 class ThreadLocalVariableData : public ThreadLocalData<LocalVarValue> {
 public:
+   DLLLOCAL ThreadLocalVariableData() : frame_block(curr) {
+   }
+
    // marks all variables as finalized on the stack
    DLLLOCAL void finalize(arg_vec_t*& cl) {
       ThreadLocalVariableData::iterator i(curr);
@@ -52,6 +59,9 @@ public:
       // then we uninstantiate
       while (curr->prev || curr->pos)
          uninstantiate(xsink);
+      frame_stack.clear();
+      frame_block = curr;
+      frame_pos = 0;
    }
 
    DLLLOCAL LocalVarValue* instantiate() {
@@ -90,10 +100,38 @@ public:
       --curr->pos;
    }
 
+   // finds the variable using the slot index in the current frame given by the hint if possible
+   /** the hint is updated with the variable's slot index if the variable has to be searched for on the stack;
+       because a local variable can only be instantiated once in a single frame, a matching variable in the
+       given slot of the current frame is always the same variable that a search on the stack would find
+    */
+   DLLLOCAL LocalVarValue* find(const char* id, std::atomic<int>& hint) {
+      int slot = hint.load(std::memory_order_relaxed);
+      if (slot >= 0) {
+         LocalVarValue* var = getFrameSlot(slot);
+         if (var && var->id == id && !var->skip && !var->frame_boundary)
+            return var;
+      }
+
+      Block* w;
+      int p;
+      LocalVarValue* var = findIntern(id, w, p);
+      slot = getFrameSlotIndex(w, p);
+      if (slot >= 0)
+         hint.store(slot, std::memory_order_relaxed);
+      return var;
+   }
+
    DLLLOCAL LocalVarValue* find(const char* id) {
-      Block* w = curr;
+      Block* w;
+      int p;
+      return findIntern(id, w, p);
+   }
+
+   DLLLOCAL LocalVarValue* findIntern(const char* id, Block*& w, int& p) {
+      w = curr;
       while (true) {
-         int p = w->pos;
+         p = w->pos;
          while (p) {
             --p;
             LocalVarValue* var = &w->var[p];
@@ -122,12 +160,20 @@ public:
       //printd(5, "ThreadLocalVariableData::pushFrameBoundary()\n");
       LocalVarValue* v = instantiate();
       v->setFrameBoundary();
+      // the current frame's slots start after the frame boundary
+      frame_stack.push_back(std::make_pair(frame_block, frame_pos));
+      frame_block = curr;
+      frame_pos = curr->pos;
    }
 
    DLLLOCAL void popFrameBoundary() {
       assert(frame_count >= 0);
       --frame_count;
       //printd(5, "ThreadLocalVariableData::popFrameBoundary()\n");
+      assert(!frame_stack.empty());
+      frame_block = frame_stack.back().first;
+      frame_pos = frame_stack.back().second;
+      frame_stack.pop_back();
       uninstantiateIntern();
       assert(curr->var[curr->pos].frame_boundary);
       curr->var[curr->pos].frame_boundary = false;
@@ -137,6 +183,37 @@ public:
 
    // returns 0 = OK, 1 = no such variable, -1 exception setting variable
    DLLLOCAL int setVarValue(const char* name, const QoreValue& val, ExceptionSink* xsink);
+
+protected:
+   // saved start positions of the calling frames
+   std::vector<std::pair<Block*, int>> frame_stack;
+   // the block and position of the first slot in the current frame
+   Block* frame_block;
+   int frame_pos = 0;
+
+   // returns the variable in the given slot of the current frame, or nullptr if the slot is not in use
+   DLLLOCAL LocalVarValue* getFrameSlot(int slot) const {
+      Block* b = frame_block;
+      int p = frame_pos + slot;
+      while (p >= QORE_THREAD_STACK_BLOCK) {
+         if (b == curr)
+            return nullptr;
+         b = b->next;
+         p -= QORE_THREAD_STACK_BLOCK;
+      }
+      return b != curr || p < curr->pos ? &b->var[p] : nullptr;
+   }
+
+   // returns the slot index in the current frame of the given position, or -1 if it's not in the current frame
+   DLLLOCAL int getFrameSlotIndex(Block* w, int p) const {
+      int slot = p - frame_pos;
+      for (Block* b = frame_block; b != w; b = b->next) {
+         if (b == curr)
+            return -1;
+         slot += QORE_THREAD_STACK_BLOCK;
+      }
+      return slot >= 0 ? slot : -1;
+   }
 };
 
 #endif
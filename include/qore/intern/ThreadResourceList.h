@@ -40,6 +40,8 @@
 
 typedef std::set<AbstractThreadResource*> trset_t;
 
+class AbstractSmartLock;
+
 struct ArgPgm {
    AbstractQoreNode* arg;
    QoreProgram* pgm;
@@ -55,6 +57,8 @@ private:
    static Sequence seq;
    trset_t trset;
    crmap_t crmap;
+   // intrusive list of exclusive smart locks held by the thread
+   AbstractSmartLock* asl_head = nullptr;
 
 public:
    ThreadResourceList* prev;
@@ -64,9 +68,12 @@ public:
 
    DLLLOCAL ~ThreadResourceList() {
       assert(trset.empty());
+      assert(!asl_head);
    }
 
    DLLLOCAL void set(AbstractThreadResource* atr);
+   // adds a lock held exclusively by the current thread to the list in O(1)
+   DLLLOCAL void setLock(AbstractSmartLock* asl);
    DLLLOCAL void set(const ResolvedCallReferenceNode* rcr, QoreValue arg);
 
    DLLLOCAL bool check(AbstractThreadResource* atr) const;
@@ -75,6 +82,8 @@ public:
    DLLLOCAL int remove(AbstractThreadResource* atr);
    // returns 0 if removed, -1 if not found
    DLLLOCAL int remove(const ResolvedCallReferenceNode* rcr, ExceptionSink* xsink);
+   // removes a lock from the list it's in, if any, in O(1); returns 0 if removed, -1 if not found
+   DLLLOCAL static int removeLock(AbstractSmartLock* asl);
 
    DLLLOCAL void purge(ExceptionSink* xsink);
 
@@ -83,7 +92,7 @@ public:
    DLLLOCAL void purge(const QoreProgram* pgm, ExceptionSink* xsink);
 
    DLLLOCAL bool empty() const {
-      return trset.empty();
+      return trset.empty() && !asl_head;
    }
 };
 
@@ -41,13 +41,16 @@
 // reentrant thread lock using tiered locking and deadlock detection infrastructure
 class VRMutex : public AbstractSmartLock {
 private:
-   int count;
+   // only modified by the thread holding the lock
+   std::atomic<int> count;
 
    DLLLOCAL virtual int releaseImpl();
    DLLLOCAL virtual int releaseImpl(ExceptionSink *xsink);
    DLLLOCAL virtual int grabImpl(int mtid, VLock *nvl, ExceptionSink *xsink, int64 timeout_ms = 0);
    DLLLOCAL virtual int tryGrabImpl(int mtid, VLock *nvl);
    DLLLOCAL virtual void cleanupImpl();
+   DLLLOCAL virtual bool grabFastImpl(int mtid, int& rc);
+   DLLLOCAL virtual bool releaseFastImpl(int mtid, int& rc);
 
 public:
    DLLLOCAL VRMutex();
@@ -61,7 +64,7 @@ public:
    DLLLOCAL virtual const char* getName() const { return "VRMutex"; }
 
    DLLLOCAL int get_count() const {
-      return count;
+      return count.load();
    }
 };
 
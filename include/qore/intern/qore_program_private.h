@@ -44,8 +44,69 @@ extern QoreHashNode* ENV;
 #include <errno.h>
 
 #include <map>
+#include <atomic>
 
-typedef std::map<int, unsigned> ptid_map_t;
+// per-thread entry counts for a Program object, indexed by TID
+/** each counter is only modified by the thread owning the TID, so entering and leaving a Program does not
+    need a lock; counters are allocated in blocks on demand so that unused Program objects stay small
+ */
+class ProgramThreadCountTable {
+public:
+   DLLLOCAL ProgramThreadCountTable() {
+      for (auto& i : blocks)
+         i.store(nullptr, std::memory_order_relaxed);
+   }
+
+   DLLLOCAL ~ProgramThreadCountTable() {
+      for (auto& i : blocks)
+         delete [] i.load(std::memory_order_relaxed);
+   }
+
+   // returns the counter for the given TID, allocating its block if necessary
+   DLLLOCAL std::atomic<unsigned>& get(int tid) {
+      assert(tid >= 0 && tid < MAX_QORE_THREADS);
+      std::atomic<std::atomic<unsigned>*>& b = blocks[tid / QPTC_BLOCK_SIZE];
+      std::atomic<unsigned>* p = b.load(std::memory_order_acquire);
+      if (!p) {
+         std::atomic<unsigned>* np = new std::atomic<unsigned>[QPTC_BLOCK_SIZE]();
+         if (b.compare_exchange_strong(p, np, std::memory_order_acq_rel, std::memory_order_acquire))
+            p = np;
+         else
+            delete [] np;
+      }
+      return p[tid % QPTC_BLOCK_SIZE];
+   }
+
+   // returns the count for the given TID without allocating anything
+   DLLLOCAL unsigned getCount(int tid) const {
+      assert(tid >= 0 && tid < MAX_QORE_THREADS);
+      std::atomic<unsigned>* p = blocks[tid / QPTC_BLOCK_SIZE].load(std::memory_order_acquire);
+      return p ? p[tid % QPTC_BLOCK_SIZE].load(std::memory_order_relaxed) : 0;
+   }
+
+   // adds the TIDs of all threads with a non-zero count to the list
+   DLLLOCAL void getThreadList(QoreListNode& l) const {
+      for (unsigned i = 0; i < QPTC_NUM_BLOCKS; ++i) {
+         std::atomic<unsigned>* p = blocks[i].load(std::memory_order_acquire);
+         if (!p)
+            continue;
+         for (unsigned j = 0; j < QPTC_BLOCK_SIZE; ++j) {
+            if (p[j].load(std::memory_order_relaxed))
+               l.push(new QoreBigIntNode(i * QPTC_BLOCK_SIZE + j));
+         }
+      }
+   }
+
+private:
+   static constexpr unsigned QPTC_BLOCK_SIZE = 256;
+   static constexpr unsigned QPTC_NUM_BLOCKS = (MAX_QORE_THREADS + QPTC_BLOCK_SIZE - 1) / QPTC_BLOCK_SIZE;
+
+   std::atomic<std::atomic<unsigned>*> blocks[QPTC_NUM_BLOCKS];
+
+   // not implemented
+   DLLLOCAL ProgramThreadCountTable(const ProgramThreadCountTable&);
+   DLLLOCAL ProgramThreadCountTable& operator=(const ProgramThreadCountTable&);
+};
 
 class QoreParseLocationHelper {
 public:
@@ -165,12 +226,12 @@ protected:
 public:
    LocalVariableList local_var_list;
 
-   // for the thread counter, used only with plock
+   // for the thread counter; waiting on pcond is only done with plock held
    QoreCondition pcond;
-   ptid_map_t tidmap;       // map of tids -> thread count in program object
-   unsigned thread_count;   // number of threads currently running in this Program
-   unsigned thread_waiting; // number of threads waiting on all threads to terminate or parsing to complete
-   unsigned parse_count;    // recursive parse count
+   ProgramThreadCountTable tcount;          // per-thread entry counts, indexed by TID
+   std::atomic<unsigned> thread_count;      // number of threads currently running in this Program
+   std::atomic<unsigned> thread_waiting;    // number of threads waiting on all threads to terminate or parsing to complete; only modified with plock held
+   unsigned parse_count;                    // recursive parse count; only used with plock
 
    // to save file names for later deleting
    cstr_vector_t fileList;
@@ -224,8 +285,8 @@ public:
 
    int tclear;   // clearing thread-local variables in progress? if so, this is the TID
 
-   int exceptions_raised,
-      ptid;      // TID of thread destroying the program's private data
+   int exceptions_raised;
+   std::atomic<int> ptid;   // TID of thread destroying the program's private data; only set with plock held
 
    ParseWarnOptions pwo;
 
@@ -411,6 +472,40 @@ public:
    // called when the program's ref count = 0 (but the dc count may not go to 0 yet)
    DLLLOCAL void clear(ExceptionSink* xsink);
 
+   // increments the thread count without taking plock; returns 0 for OK, -1 if the Program is being deleted
+   /** the thread count is incremented before ptid is checked and waitForTerminationAndClear() checks the
+       thread count again after setting ptid, so a thread is either rejected here or waited for there; threads
+       already running in the Program may always reenter it
+    */
+   DLLLOCAL int incThreadCountIntern() {
+      int tid = gettid();
+      std::atomic<unsigned>& c = tcount.get(tid);
+
+      ++thread_count;
+      int p = ptid.load();
+      if (p && p != tid && !c.load(std::memory_order_relaxed)) {
+         decThreadCountIntern();
+         return -1;
+      }
+
+      c.fetch_add(1, std::memory_order_relaxed);
+      return 0;
+   }
+
+   // decrements the thread count and wakes up any waiting threads; plock is only acquired if there are waiters
+   /** waiters increment thread_waiting before checking the thread count, so with sequentially-consistent
+       operations either the waiter sees the new count or this thread sees the waiter and signals it while
+       holding plock, after the waiter has started waiting
+    */
+   DLLLOCAL void decThreadCountIntern() {
+      unsigned c = thread_count--;
+      assert(c > 0);
+      if (thread_waiting.load()) {
+         AutoLocker al(plock);
+         pcond.broadcast();
+      }
+   }
+
    // called when starting a new thread before the new thread is started, to avoid race conditions
    // once the new thread has been started, the TID is registered in startThread()
    DLLLOCAL int preregisterNewThread(ExceptionSink* xsink) {
@@ -428,21 +523,13 @@ public:
 
    // called when thread startup fails after preregistration
    DLLLOCAL void cancelPreregistration() {
-      // grab program-level lock
-      AutoLocker al(plock);
-
-      assert(thread_count > 0);
-      if (!--thread_count && thread_waiting)
-         pcond.broadcast();
+      decThreadCountIntern();
    }
 
    // called from the new thread once the thread has been started (after preregisterNewThread())
    DLLLOCAL void registerNewThread(int tid) {
-      // grab program-level lock
-      AutoLocker al(plock);
-
       assert(thread_count);
-      ++tidmap[tid];
+      ++tcount.get(tid);
    }
 
    /*
@@ -457,57 +544,30 @@ public:
 
    // returns 0 for OK, -1 for error
    DLLLOCAL int incThreadCount(ExceptionSink* xsink) {
-      int tid = gettid();
-
-      // grab program-level lock
-      AutoLocker al(plock);
-
-      if (ptid && ptid != tid) {
+      if (incThreadCountIntern()) {
          xsink->raiseException("PROGRAM-ERROR", "the Program accessed has already been deleted and therefore cannot be accessed at runtime");
          return -1;
       }
-
-      ++tidmap[tid];
-      ++thread_count;
       return 0;
    }
 
    // throws a QoreStandardException if there is an error
    DLLLOCAL void incThreadCount() {
-      int tid = gettid();
-
-      // grab program-level lock
-      AutoLocker al(plock);
-
-      if (ptid && ptid != tid)
+      if (incThreadCountIntern())
          throw QoreStandardException("PROGRAM-ERROR", "the Program accessed has already been deleted and therefore cannot be accessed at runtime");
-
-      ++tidmap[tid];
-      ++thread_count;
    }
 
    DLLLOCAL void decThreadCount(int tid) {
-      // grab program-level lock
-      AutoLocker al(plock);
+      std::atomic<unsigned>& c = tcount.get(tid);
+      assert(c.load(std::memory_order_relaxed) > 0);
+      c.fetch_sub(1, std::memory_order_relaxed);
 
-      ptid_map_t::iterator i = tidmap.find(tid);
-      assert(i != tidmap.end());
-      if (!--i->second)
-         tidmap.erase(i);
-
-      assert(thread_count > 0);
-      if (!--thread_count && thread_waiting)
-         pcond.broadcast();
+      decThreadCountIntern();
    }
 
    // gets a list of all thread IDs using this Program
    DLLLOCAL void getThreadList(QoreListNode& l) {
-      // grab program-level lock
-      AutoLocker al(plock);
-
-      for (auto& i : tidmap) {
-         l.push(new QoreBigIntNode(i.first));
-      }
+      tcount.getThreadList(l);
    }
 
    DLLLOCAL int lockParsing(ExceptionSink* xsink) {
@@ -515,12 +575,11 @@ public:
       AutoLocker al(plock);
 
       bool curr = (pgm == getProgram());
-      if (!curr) {
-         while (parse_count) {
-            ++thread_waiting;
+      if (!curr && parse_count) {
+         ++thread_waiting;
+         while (parse_count)
             pcond.wait(plock);
-            --thread_waiting;
-         }
+         --thread_waiting;
       }
 
       if (ptid && ptid != gettid()) {
@@ -543,16 +602,13 @@ public:
 
    // called only with plock held
    DLLLOCAL void waitForAllThreadsToTerminateIntern() {
-      int tid = gettid();
+      unsigned adj = tcount.getCount(gettid()) ? 1 : 0;
 
-      ptid_map_t::iterator i = tidmap.find(tid);
-      unsigned adj = (i != tidmap.end() ? 1 : 0);
-
-      while ((thread_count - adj) || parse_count) {
-         ++thread_waiting;
+      // the waiter count must be incremented before the thread count is checked; see decThreadCountIntern()
+      ++thread_waiting;
+      while ((thread_count - adj) || parse_count)
          pcond.wait(plock);
-         --thread_waiting;
-      }
+      --thread_waiting;
    }
 
    DLLLOCAL void waitForAllThreadsToTerminate() {
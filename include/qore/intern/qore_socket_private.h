@@ -33,8 +33,10 @@
 #define _QORE_QORE_SOCKET_PRIVATE_H
 
 #include "qore/intern/SSLSocketHelper.h"
+#include "qore/intern/QoreSSLContext.h"
 
 #include "qore/intern/QC_Queue.h"
+#include "qore/intern/QoreDnsCache.h"
 
 #include <ctype.h>
 #include <stdlib.h>
@@ -43,6 +45,8 @@
 #include <errno.h>
 #include <ctype.h>
 
+#include <vector>
+
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
@@ -60,6 +64,54 @@
 #define DEFAULT_SOCKET_BUFSIZE 4096
 #endif
 
+// gathered writes for HTTP headers and message bodies
+#if defined HAVE_WRITEV && defined HAVE_SYS_UIO_H
+#define QORE_USE_WRITEV 1
+#endif
+
+// zero-copy file transfers; the Linux sendfile() signature is assumed
+#if defined HAVE_SENDFILE && defined HAVE_SYS_SENDFILE_H && defined __linux__
+#define QORE_USE_SENDFILE 1
+#endif
+
+// TLS messages up to this size are coalesced into a single write (the maximum TLS record size)
+#ifndef QORE_SSL_COALESCE_SIZE
+#define QORE_SSL_COALESCE_SIZE 16384
+#endif
+
+// the maximum number of bytes sent with a single sendfile() call
+#ifndef QORE_SENDFILE_CHUNK
+#define QORE_SENDFILE_CHUNK (1024 * 1024)
+#endif
+
+// the default size of the buffer for buffered socket reads
+#ifndef QORE_SOCKET_READ_BUFSIZE
+#define QORE_SOCKET_READ_BUFSIZE 16384
+#endif
+
+// the maximum size of the buffer for buffered socket reads
+#define QORE_SOCKET_MAX_READ_BUFSIZE (16 * 1024 * 1024)
+
+// the maximum number of bytes allocated for a known-length read before data has been received
+#ifndef QORE_SOCKET_MAX_PRESIZE
+#define QORE_SOCKET_MAX_PRESIZE (1024 * 1024)
+#endif
+
+// the minimum block size for reading data into an output stream
+#ifndef QORE_SOCKET_STREAM_BUFSIZE
+#define QORE_SOCKET_STREAM_BUFSIZE 65536
+#endif
+
+// parallel connection attempts to IPv6 and IPv4 addresses ("happy eyeballs", RFC 8305)
+#if defined HAVE_POLL && !defined _Q_WINDOWS
+#define QORE_PARALLEL_CONNECT 1
+#endif
+
+// the delay in milliseconds before the next connection attempt is started in parallel
+#ifndef QORE_CONNECT_ATTEMPT_DELAY
+#define QORE_CONNECT_ATTEMPT_DELAY 250
+#endif
+
 #ifndef QORE_MAX_HEADER_SIZE
 #define QORE_MAX_HEADER_SIZE 16384
 #endif
@@ -67,6 +119,8 @@
 #define CHF_HTTP11  (1 << 0)
 #define CHF_PROCESS (1 << 1)
 #define CHF_REQUEST (1 << 2)
+// do not set the socket's character encoding from the header
+#define CHF_NO_ENCODING (1 << 3)
 
 #ifndef DEFAULT_SOCKET_MIN_THRESHOLD_BYTES
 #define DEFAULT_SOCKET_MIN_THRESHOLD_BYTES 1024
@@ -213,17 +267,28 @@ struct qore_socket_private {
    const QoreEncoding* enc;
 
    std::string socketname;
+   // the host name given when connecting with connectINET(); used to key TLS client sessions by server name
+   std::string peer_host;
    SSLSocketHelper* ssl = nullptr;
+   // shared TLS/SSL context, if any
+   QoreSSLContext* ssl_ctx = nullptr;
    Queue* cb_queue = nullptr,
       * warn_queue = nullptr;
 
-   // socket buffer for buffered reads
-   char rbuf[DEFAULT_SOCKET_BUFSIZE];
+   // socket buffer for buffered reads; allocated on demand
+   char* rbuf = nullptr;
+   // the size of the read buffer
+   size_t rbuf_size = QORE_SOCKET_READ_BUFSIZE;
 
    // current buffer size
    size_t buflen = 0,
       bufoffset = 0;
 
+   // the data frames of a fragmented WebSocket message received so far
+   BinaryNode* ws_frag = nullptr;
+   // the opcode of the first frame of the fragmented WebSocket message
+   int ws_frag_op = 0;
+
    int64 tl_warning_us = 0;     // timeout threshold for network action warning in microseconds
    double tp_warning_bs = 0;    // throughput warning threshold in B/s
    int64 tp_bytes_sent = 0,     // throughput: bytes sent
@@ -236,7 +301,9 @@ struct qore_socket_private {
    AbstractQoreNode* callback_arg = nullptr;
    bool del = false,
       http_exp_chunked_body = false,
-      ssl_accept_all_certs = false;
+      ssl_accept_all_certs = false,
+      // set SO_REUSEPORT when binding
+      reuseport = false;
    int in_op = -1,
       ssl_verify_mode = SSL_VERIFY_NONE;
 
@@ -247,6 +314,12 @@ struct qore_socket_private {
    DLLLOCAL ~qore_socket_private() {
       close_internal();
 
+      if (ssl_ctx)
+         ssl_ctx->deref();
+
+      if (rbuf)
+         free(rbuf);
+
       // must be dereferenced and removed before deleting
       assert(!cb_queue);
       assert(!warn_queue);
@@ -256,6 +329,46 @@ struct qore_socket_private {
       return sock != QORE_INVALID_SOCKET;
    }
 
+   // returns the read buffer, allocating it if necessary
+   DLLLOCAL char* getReadBuffer() {
+      if (!rbuf)
+         rbuf = (char*)malloc(rbuf_size);
+      return rbuf;
+   }
+
+   DLLLOCAL size_t getReadBufferSize() const {
+      return rbuf_size;
+   }
+
+   // sets the size of the buffer for buffered reads; any buffered data is retained
+   DLLLOCAL int setReadBufferSize(int64 size, ExceptionSink* xsink);
+
+   // reads up to bs bytes directly into the caller's buffer; buffered data is returned first
+   DLLLOCAL qore_offset_t brecvDirect(ExceptionSink* xsink, const char* meth, char* dest, qore_size_t bs, int timeout);
+
+   // reads size bytes or until the connection is closed into a new buffer allocated with malloc() that is also
+   // terminated with a null byte; len is set to the number of bytes read
+   DLLLOCAL char* recvSized(ExceptionSink* xsink, const char* meth, qore_size_t size, int timeout, qore_offset_t& rc, qore_size_t& len);
+
+   // reads exactly size bytes into the caller's buffer; raises an exception and returns -1 on error
+   DLLLOCAL int recvExact(ExceptionSink* xsink, const char* meth, char* dest, qore_size_t size, int timeout);
+
+   // reads a complete WebSocket message, reassembling fragmented messages; control frames received between the
+   // fragments of a message are returned immediately
+   DLLLOCAL QoreHashNode* readWebSocketMessage(ExceptionSink* xsink, int timeout, int64 max_size);
+
+   // returns a hash for a WebSocket message received; takes over the reference to the payload
+   DLLLOCAL QoreHashNode* getWebSocketMessage(int op, bool masked, BinaryNode* b);
+
+   // sets the shared TLS/SSL context used for new TLS/SSL connections; 0 = create a new context for each connection
+   DLLLOCAL void setSSLContext(QoreSSLContext* ctx) {
+      if (ctx)
+         ctx->ref();
+      if (ssl_ctx)
+         ssl_ctx->deref();
+      ssl_ctx = ctx;
+   }
+
    DLLLOCAL int close() {
       int rc = close_internal();
       if (in_op >= 0)
@@ -288,6 +401,10 @@ struct qore_socket_private {
          buflen = 0;
       if (bufoffset)
          bufoffset = 0;
+      if (ws_frag) {
+         ws_frag->deref();
+         ws_frag = nullptr;
+      }
       if (del)
          del = false;
       if (port != -1)
@@ -310,6 +427,7 @@ struct qore_socket_private {
                unlink(socketname.c_str());
             socketname.clear();
          }
+         peer_host.clear();
          do_close_event();
          return close_and_reset();
       }
@@ -447,6 +565,9 @@ struct qore_socket_private {
          return QSE_NOT_OPEN;
       if (in_op >= 0)
          return QSE_IN_OP;
+      // a negative backlog means the system maximum
+      if (backlog < 0)
+         backlog = SOMAXCONN;
 #ifdef _Q_WINDOWS
       if (::listen(sock, backlog)) {
          // set errno
@@ -482,6 +603,12 @@ struct qore_socket_private {
       }
    }
 
+   // accepts all pending connections up to max after waiting for the first one; the descriptors are added to fds
+   DLLLOCAL int acceptBatch(ExceptionSink* xsink, std::vector<int>& fds, int max, int timeout_ms);
+
+   // returns a new socket object for a descriptor accepted on this socket with the settings of this socket
+   DLLLOCAL QoreSocket* newAccepted(int fd) const;
+
    // returns a new socket
    DLLLOCAL int accept_internal(ExceptionSink* xsink, SocketSource *source, int timeout_ms = -1) {
       assert(xsink);
@@ -733,37 +860,43 @@ struct qore_socket_private {
 
    DLLLOCAL void do_resolve_event(const char* host, const char* service = 0) {
       // post bytes sent on event queue, if any
-      if (cb_queue) {
-         QoreHashNode* h = new QoreHashNode;
-         h->setKeyValue("event", new QoreBigIntNode(QORE_EVENT_HOSTNAME_LOOKUP), 0);
-         h->setKeyValue("source", new QoreBigIntNode(QORE_SOURCE_SOCKET), 0);
-         h->setKeyValue("id", new QoreBigIntNode((int64)this), 0);
-         if (host)
-            h->setKeyValue("name", new QoreStringNode(host), 0);
-         if (service)
-            h->setKeyValue("service", new QoreStringNode(service), 0);
-         cb_queue->pushAndTakeRef(h);
-      }
+      if (cb_queue)
+         post_resolve_event(cb_queue, (int64)this, host, service);
    }
 
    DLLLOCAL void do_resolved_event(const struct sockaddr* addr) {
       // post bytes sent on event queue, if any
-      if (cb_queue) {
-         QoreHashNode* h = new QoreHashNode;
-         h->setKeyValue("event", new QoreBigIntNode(QORE_EVENT_HOSTNAME_RESOLVED), 0);
-         h->setKeyValue("source", new QoreBigIntNode(QORE_SOURCE_SOCKET), 0);
-         h->setKeyValue("id", new QoreBigIntNode((int64)this), 0);
-         QoreStringNode* str = q_addr_to_string2(addr);
-         if (str)
-            h->setKeyValue("address", str, 0);
-         else
-            h->setKeyValue("error", q_strerror(sock_get_error()), 0);
-         int prt = q_get_port_from_addr(addr);
-         if (prt > 0)
-            h->setKeyValue("port", new QoreBigIntNode(prt), 0);
-         q_af_to_hash(addr->sa_family, *h, 0);
-         cb_queue->pushAndTakeRef(h);
-      }
+      if (cb_queue)
+         post_resolved_event(cb_queue, (int64)this, addr);
+   }
+
+   DLLLOCAL static void post_resolve_event(Queue* q, int64 id, const char* host, const char* service) {
+      QoreHashNode* h = new QoreHashNode;
+      h->setKeyValue("event", new QoreBigIntNode(QORE_EVENT_HOSTNAME_LOOKUP), 0);
+      h->setKeyValue("source", new QoreBigIntNode(QORE_SOURCE_SOCKET), 0);
+      h->setKeyValue("id", new QoreBigIntNode(id), 0);
+      if (host)
+         h->setKeyValue("name", new QoreStringNode(host), 0);
+      if (service)
+         h->setKeyValue("service", new QoreStringNode(service), 0);
+      q->pushAndTakeRef(h);
+   }
+
+   DLLLOCAL static void post_resolved_event(Queue* q, int64 id, const struct sockaddr* addr) {
+      QoreHashNode* h = new QoreHashNode;
+      h->setKeyValue("event", new QoreBigIntNode(QORE_EVENT_HOSTNAME_RESOLVED), 0);
+      h->setKeyValue("source", new QoreBigIntNode(QORE_SOURCE_SOCKET), 0);
+      h->setKeyValue("id", new QoreBigIntNode(id), 0);
+      QoreStringNode* str = q_addr_to_string2(addr);
+      if (str)
+         h->setKeyValue("address", str, 0);
+      else
+         h->setKeyValue("error", q_strerror(sock_get_error()), 0);
+      int prt = q_get_port_from_addr(addr);
+      if (prt > 0)
+         h->setKeyValue("port", new QoreBigIntNode(prt), 0);
+      q_af_to_hash(addr->sa_family, *h, 0);
+      q->pushAndTakeRef(h);
    }
 
    DLLLOCAL int64 getObjectIDForEvents() const {
@@ -944,7 +1077,7 @@ struct qore_socket_private {
          return b;
       // select can return true if there is protocol negotiation data available,
       // so we try to read 1 byte with a timeout of 0 with the SSL connection
-      int rc = ssl->doSSLRW(xsink, mname, rbuf, 1, 0, true, false);
+      int rc = ssl->doSSLRW(xsink, mname, getReadBuffer(), 1, 0, true, false);
       if (*xsink || (rc == QSE_TIMEOUT))
          return false;
       if (rc == 1)
@@ -958,12 +1091,118 @@ struct qore_socket_private {
       return asyncIoWait(timeout_ms, true, false, "Socket", mname, xsink);
    }
 
+   // returns true if data has already been read from the socket and can be returned without waiting
+   DLLLOCAL bool hasBufferedData() const {
+      return buflen || (ssl && ssl->pending() > 0);
+   }
+
    DLLLOCAL bool isDataAvailable(int timeout_ms, const char* mname, ExceptionSink* xsink) {
-      if (buflen)
+      if (hasBufferedData())
          return true;
       return isSocketDataAvailable(timeout_ms, mname, xsink);
    }
 
+   // reads any data that can be read without blocking into the free space at the end of the read buffer
+   DLLLOCAL int fillReadBuffer(const char* mname, ExceptionSink* xsink) {
+      char* b = getReadBuffer();
+      if (bufoffset) {
+         memmove(b, b + bufoffset, buflen);
+         bufoffset = 0;
+      }
+      if (buflen == rbuf_size)
+         return 0;
+
+      if (!(ssl && ssl->pending() > 0) && !isSocketDataAvailable(0, mname, xsink))
+         return *xsink ? -1 : 0;
+
+      qore_offset_t rc;
+      if (!ssl) {
+         while (true) {
+            rc = ::recv(sock, b + buflen, rbuf_size - buflen, 0);
+            if (rc == QORE_SOCKET_ERROR) {
+               sock_get_error();
+               if (errno == EINTR)
+                  continue;
+            }
+            break;
+         }
+      }
+      else {
+         rc = ssl->doSSLRW(xsink, mname, b + buflen, rbuf_size - buflen, 0, true, false);
+         if (*xsink)
+            return -1;
+      }
+
+      // errors and a remote close are reported by the next blocking read
+      if (rc > 0)
+         buflen += rc;
+      return 0;
+   }
+
+   // returns true if a complete HTTP header and any message body declared with a Content-Length header can be read
+   // without blocking
+   DLLLOCAL bool isHttpMessageBuffered(const char* mname, ExceptionSink* xsink) {
+      if (sock == QORE_INVALID_SOCKET) {
+         se_not_open("Socket", mname, xsink);
+         return false;
+      }
+      if (fillReadBuffer(mname, xsink) || !buflen)
+         return false;
+
+      const char* start = rbuf + bufoffset;
+      const char* end = start + buflen;
+
+      // find the end of the header with the same rules as readHTTPData()
+      const char* hdr_end = nullptr;
+      int state = -1;
+      for (const char* p = start; p < end; ++p) {
+         if (*p == '\n') {
+            if (state == -1) {
+               state = 3;
+               continue;
+            }
+            if (!state) {
+               state = 1;
+               continue;
+            }
+            hdr_end = p + 1;
+            break;
+         }
+         if (*p == '\r') {
+            if (state == -1) {
+               state = 0;
+               continue;
+            }
+            if (!state) {
+               hdr_end = p + 1;
+               break;
+            }
+            if (state == 1) {
+               state = 2;
+               continue;
+            }
+         }
+         state = -1;
+      }
+      if (!hdr_end)
+         return false;
+
+      // check for a Content-Length header
+      int64 len = 0;
+      for (const char* p = start; p < hdr_end; ) {
+         const char* eol = (const char*)memchr(p, '\n', hdr_end - p);
+         if (!eol)
+            eol = hdr_end;
+         if ((eol - p) > 15 && !strncasecmp(p, "content-length:", 15)) {
+            len = strtoll(p + 15, nullptr, 10);
+            break;
+         }
+         p = eol + 1;
+      }
+
+      return (end - hdr_end) >= len;
+   }
+
    DLLLOCAL bool isWriteFinished(int timeout_ms, const char* mname, ExceptionSink* xsink) {
       return asyncIoWait(timeout_ms, false, true, "Socket", mname, xsink);
    }
@@ -1112,13 +1351,17 @@ struct qore_socket_private {
 
       printd(5, "qore_socket_private::connectINET(%s:%s, %dms)\n", host, service, timeout_ms);
 
+      if (host)
+         peer_host = host;
+
       do_resolve_event(host, service);
 
-      QoreAddrInfo ai;
-      if (ai.getInfo(xsink, host, service, family, 0, type, protocol))
+      // lookups are served from the DNS cache where possible
+      dns_entry_t e = QDC.get(xsink, host, service, family, 0, type, protocol);
+      if (!e)
          return -1;
 
-      struct addrinfo *aip = ai.getAddrInfo();
+      struct addrinfo *aip = e->ai;
 
       // emit all "resolved" events
       if (cb_queue)
@@ -1127,6 +1370,14 @@ struct qore_socket_private {
 
       int prt = q_get_port_from_addr(aip->ai_addr);
 
+#ifdef QORE_PARALLEL_CONNECT
+      // connect to IPv6 and IPv4 addresses in parallel if both are available
+      for (struct addrinfo *p = aip->ai_next; p; p = p->ai_next) {
+         if (p->ai_family != aip->ai_family)
+            return connectINETParallel(host, service, aip, prt, timeout_ms, xsink);
+      }
+#endif
+
       for (struct addrinfo *p = aip; p; p = p->ai_next) {
          if (!connectINETIntern(host, service, p->ai_family, p->ai_addr, p->ai_addrlen, p->ai_socktype, p->ai_protocol, prt, timeout_ms, xsink, true))
             return 0;
@@ -1139,6 +1390,15 @@ struct qore_socket_private {
       return -1;
    }
 
+#ifdef QORE_PARALLEL_CONNECT
+   // connects to the first address that accepts the connection, starting a new attempt in parallel every
+   // QORE_CONNECT_ATTEMPT_DELAY ms with address families interleaved
+   DLLLOCAL int connectINETParallel(const char* host, const char* service, const struct addrinfo* aip, int prt, int timeout_ms, ExceptionSink* xsink);
+#endif
+
+   // resolves the name into the DNS cache in a background thread; lookup events are posted on the event queue, if any
+   DLLLOCAL int resolveAsync(const char* host, const char* service, int family, ExceptionSink* xsink);
+
    DLLLOCAL int connectINETIntern(const char* host, const char* service, int ai_family, struct sockaddr* ai_addr, size_t ai_addrlen, int ai_socktype, int ai_protocol, int prt, int timeout_ms, ExceptionSink* xsink, bool only_timeout = false) {
       assert(xsink);
       printd(5, "qore_socket_private::connectINETIntern() host: %s service: %s family: %d timeout_ms: %d\n", host, service, ai_family, timeout_ms);
@@ -1267,6 +1527,20 @@ struct qore_socket_private {
    DLLLOCAL int bindIntern(struct sockaddr* ai_addr, size_t ai_addrlen, int prt, bool reuseaddr, ExceptionSink* xsink = 0) {
       reuse(reuseaddr);
 
+#ifdef SO_REUSEPORT
+      // allows several sockets to be bound to the same address and port with incoming connections distributed
+      // among them by the kernel
+      if (reuseport) {
+         int opt = 1;
+         if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (SETSOCKOPT_ARG_4)&opt, sizeof(int))) {
+            if (xsink)
+               qore_socket_error(xsink, "SOCKET-BIND-ERROR", "error setting SO_REUSEPORT", 0, 0, 0, ai_addr);
+            close();
+            return -1;
+         }
+      }
+#endif
+
       if ((::bind(sock, ai_addr, ai_addrlen)) == QORE_SOCKET_ERROR) {
          if (xsink)
             qore_socket_error(xsink, "SOCKET-BIND-ERROR", "error in bind()", 0, 0, 0, ai_addr);
@@ -1536,7 +1810,7 @@ struct qore_socket_private {
 #ifdef DEBUG
             errno = 0;
 #endif
-            rc = ::recv(sock, rbuf, DEFAULT_SOCKET_BUFSIZE, flags);
+            rc = ::recv(sock, getReadBuffer(), rbuf_size, flags);
             if (rc == QORE_SOCKET_ERROR) {
                sock_get_error();
                if (errno == EINTR)
@@ -1558,7 +1832,7 @@ struct qore_socket_private {
          }
       }
       else
-         rc = ssl->read(meth, rbuf, DEFAULT_SOCKET_BUFSIZE, timeout, xsink);
+         rc = ssl->read(meth, getReadBuffer(), rbuf_size, timeout, xsink);
 
       //printd(5, "qore_socket_private::brecv(%d, %p, %ld, %d) rc: %ld errno: %d\n", sock, buf, bs, flags, rc, errno);
       if (rc > 0) {
@@ -1703,7 +1977,21 @@ struct qore_socket_private {
 
       PrivateQoreSocketThroughputHelper th(this, false);
 
-      qore_size_t bs = bufsize > 0 && bufsize < DEFAULT_SOCKET_BUFSIZE ? bufsize : DEFAULT_SOCKET_BUFSIZE;
+      // known-length reads are received directly into the string buffer
+      if (bufsize > 0) {
+         qore_size_t len;
+         char* buf = recvSized(xsink, "recv", bufsize, timeout, rc, len);
+         th.finalize(len);
+         if (*xsink) {
+            free(buf);
+            return 0;
+         }
+         if (rc >= 0)
+            rc = len;
+         return new QoreStringNode(buf, len, len + 1, enc);
+      }
+
+      qore_size_t bs = rbuf_size;
 
       QoreStringNodeHolder str(new QoreStringNode(enc));
 
@@ -1720,14 +2008,7 @@ struct qore_socket_private {
          str->concat(buf, rc);
 
          // register event
-         do_read_event(rc, str->size(), bufsize);
-
-         if (bufsize > 0) {
-            if (str->size() >= (qore_size_t)bufsize)
-               break;
-            if ((bufsize - str->size()) < bs)
-               bs = bufsize - str->size();
-         }
+         do_read_event(rc, str->size());
       }
 
       printd(5, "qore_socket_private::recv() received " QSD " byte(s), bufsize=" QSD ", strlen=" QSD " str='%s'\n", str->size(), bufsize, (str ? str->strlen() : 0), str ? str->getBuffer() : "n/a");
@@ -1763,7 +2044,7 @@ struct qore_socket_private {
 
       // perform first read with timeout
       char* buf;
-      rc = brecv(xsink, "recv", buf, DEFAULT_SOCKET_BUFSIZE, 0, timeout, false);
+      rc = brecv(xsink, "recv", buf, rbuf_size, 0, timeout, false);
       if (rc <= 0)
          return 0;
 
@@ -1775,7 +2056,7 @@ struct qore_socket_private {
       // keep reading data until no more data is available without a timeout
       if (isDataAvailable(0, "recv", xsink)) {
          do {
-            rc = brecv(xsink, "recv", buf, DEFAULT_SOCKET_BUFSIZE, 0, 0, false);
+            rc = brecv(xsink, "recv", buf, rbuf_size, 0, 0, false);
             //printd(5, "qore_socket_private::recv(to: %d) rc=" QSD " rd=" QSD "\n", timeout, rc, str->size());
             // if the remote end has closed the connection, return what we have
             if (!rc)
@@ -1820,7 +2101,22 @@ struct qore_socket_private {
 
       PrivateQoreSocketThroughputHelper th(this, false);
 
-      qore_size_t bs = bufsize > 0 && bufsize < DEFAULT_SOCKET_BUFSIZE ? bufsize : DEFAULT_SOCKET_BUFSIZE;
+      // known-length reads are received directly into the binary buffer
+      if (bufsize > 0) {
+         qore_size_t len;
+         char* buf = recvSized(xsink, "recvBinary", bufsize, timeout, rc, len);
+         th.finalize(len);
+         if (*xsink) {
+            free(buf);
+            return 0;
+         }
+         if (rc >= 0)
+            rc = len;
+         printd(5, "qore_socket_private::recvBinary() received " QSD " byte(s), bufsize=" QSD "\n", len, bufsize);
+         return new BinaryNode(buf, len);
+      }
+
+      qore_size_t bs = rbuf_size;
 
       SimpleRefHolder<BinaryNode> b(new BinaryNode);
 
@@ -1831,13 +2127,6 @@ struct qore_socket_private {
             break;
 
          b->append(buf, rc);
-
-         if (bufsize > 0) {
-            if (b->size() >= (qore_size_t)bufsize)
-               break;
-            if ((bufsize - b->size()) < bs)
-               bs = bufsize - b->size();
-         }
       }
 
       th.finalize(b->size());
@@ -1876,7 +2165,7 @@ struct qore_socket_private {
       //printd(5, "QoreSocket::recvBinary(%d, " QSD ") this: %p\n", timeout, rc, this);
       // perform first read with timeout
       char* buf;
-      rc = brecv(xsink, "recvBinary", buf, DEFAULT_SOCKET_BUFSIZE, 0, timeout, false);
+      rc = brecv(xsink, "recvBinary", buf, rbuf_size, 0, timeout, false);
       if (rc <= 0)
          return 0;
 
@@ -1888,7 +2177,7 @@ struct qore_socket_private {
       // keep reading data until no more data is available without a timeout
       if (isDataAvailable(0, "recvBinary", xsink)) {
          do {
-            rc = brecv(xsink, "recvBinary", buf, DEFAULT_SOCKET_BUFSIZE, 0, 0, false);
+            rc = brecv(xsink, "recvBinary", buf, rbuf_size, 0, 0, false);
             // if the remote end has closed the connection, return what we have
             if (!rc)
                break;
@@ -1930,13 +2219,19 @@ struct qore_socket_private {
 
       qore_socket_op_helper oh(this);
 
-      char* buf;
+      // data is read in large blocks directly into a temporary buffer
+      qore_size_t bs = QORE_MAX(rbuf_size, (qore_size_t)QORE_SOCKET_STREAM_BUFSIZE);
+      if (size > 0 && (qore_size_t)size < bs)
+         bs = size;
+      char* buf = (char*)malloc(bs);
+      ON_BLOCK_EXIT(free, buf);
+
       qore_offset_t br = 0;
       while (size < 0 || br < size) {
          // calculate bytes needed
-         int bn = size < 0 ? DEFAULT_SOCKET_BUFSIZE : QORE_MIN(size - br, DEFAULT_SOCKET_BUFSIZE);
+         qore_size_t bn = size < 0 ? bs : QORE_MIN((qore_size_t)(size - br), bs);
 
-         qore_offset_t rc = brecv(xsink, "recvToOutputStream", buf, bn, 0, timeout);
+         qore_offset_t rc = brecvDirect(xsink, "recvToOutputStream", buf, bn, timeout);
          if (rc < 0) {
             //error - already reported in xsink
             return;
@@ -1950,6 +2245,8 @@ struct qore_socket_private {
             return;
          }
 
+         do_read_event(rc, br + rc, size < 0 ? 0 : size);
+
          // write buffer to the stream
          {
             AutoUnlocker al(l);
@@ -1975,7 +2272,7 @@ struct qore_socket_private {
       return hdr.release();
    }
 
-   DLLLOCAL AbstractQoreNode* readHTTPHeader(ExceptionSink* xsink, QoreHashNode* info, int timeout, qore_offset_t& rc, int source) {
+   DLLLOCAL AbstractQoreNode* readHTTPHeader(ExceptionSink* xsink, QoreHashNode* info, int timeout, qore_offset_t& rc, int source, bool set_encoding = true) {
       assert(xsink);
       QoreStringNodeHolder hdr(readHTTPData(xsink, "readHTTPHeader", timeout, rc));
       if (!hdr) {
@@ -2024,6 +2321,8 @@ struct qore_socket_private {
 
       // process header flags
       int flags = CHF_PROCESS;
+      if (!set_encoding)
+         flags |= CHF_NO_ENCODING;
 
       // get version
       {
@@ -2363,10 +2662,52 @@ struct qore_socket_private {
       return rc;
    }
 
+   // sends two buffers as if they were one; non-TLS connections use a single gathered write where possible
+   DLLLOCAL qore_offset_t sendvIntern(ExceptionSink* xsink, const char* cname, const char* mname, const char* b1, qore_size_t s1, const char* b2, qore_size_t s2, int timeout_ms, int64& total);
+
+   // sends data from a regular file with sendfile(); returns 1 if sendfile() cannot be used for the descriptor (in
+   // which case no data has been sent), -1 for errors, and 0 for success; the number of bytes sent is added to total
+   DLLLOCAL int sendFileIntern(ExceptionSink* xsink, const char* cname, const char* mname, int fd, int64 size, int timeout_ms, int64& total);
+
+   // sends data from a FileInputStream with sendfile(); returns 1 if the stream cannot be sent this way, -1 for
+   // errors, and 0 for success; the number of bytes sent is added to total
+   DLLLOCAL int sendFromFileInputStream(InputStream* is, int64 size, int64 timeout, int64& total, ExceptionSink* xsink);
+
    DLLLOCAL int send(ExceptionSink* xsink, const char* mname, const char* buf, qore_size_t size, int timeout_ms = -1) {
       return send(xsink, "Socket", mname, buf, size, timeout_ms);
    }
 
+   // sends a message header and body together
+   DLLLOCAL int sendv(ExceptionSink* xsink, const char* cname, const char* mname, const char* hdr, qore_size_t hdr_size, const char* body, qore_size_t size, int timeout_ms = -1) {
+      assert(xsink);
+      if (sock == QORE_INVALID_SOCKET) {
+         se_not_open(cname, mname, xsink);
+
+         return QSE_NOT_OPEN;
+      }
+      if (in_op >= 0) {
+         if (in_op == gettid()) {
+            se_in_op(cname, mname, xsink);
+            return 0;
+         }
+         se_in_op_thread(cname, mname, xsink);
+         return 0;
+      }
+
+      PrivateQoreSocketThroughputHelper th(this, true);
+
+      // set non-blocking I/O (and restore on exit) if we have a timeout and a non-ssl connection
+      OptionalNonBlockingHelper onbh(*this, !ssl && timeout_ms >= 0, xsink);
+      if (*xsink)
+         return -1;
+
+      int64 total = 0;
+      qore_offset_t rc = sendvIntern(xsink, cname, mname, hdr, hdr_size, body, size, timeout_ms, total);
+      th.finalize(total);
+
+      return rc < 0 || sock == QORE_INVALID_SOCKET ? rc : 0;
+   }
+
    DLLLOCAL int send(int fd, qore_offset_t size, int timeout_ms, ExceptionSink* xsink);
 
    DLLLOCAL int send(ExceptionSink* xsink, const char* cname, const char* mname, const char* buf, qore_size_t size, int timeout_ms = -1) {
@@ -2426,9 +2767,20 @@ struct qore_socket_private {
       if (*xsink)
          return;
 
+      int64 total = 0;
+
+      // send regular files without copying the data through user space if possible
+      {
+         int rc = sendFromFileInputStream(is, size, timeout, total, xsink);
+         if (rc <= 0) {
+            if (!rc)
+               th.finalize(total);
+            return;
+         }
+      }
+
       char buf[DEFAULT_SOCKET_BUFSIZE];
       int64 sent = 0;
-      int64 total = 0;
       while (size < 0 || sent < size) {
          int64 toRead = size < 0 ? DEFAULT_SOCKET_BUFSIZE : QORE_MIN(size - sent, DEFAULT_SOCKET_BUFSIZE);
          int64 r;
@@ -2604,13 +2956,15 @@ struct qore_socket_private {
 
       //printd(5, "qore_socket_private::sendHttpMessage() hdr: %s\n", hdr.getBuffer());
 
+      // send the header and body together to avoid a separate system call and packet for the body
+      if (size && data)
+         return sendv(xsink, cname, mname, hdr.getBuffer(), hdr.strlen(), (const char*)data, size, timeout_ms);
+
       int rc;
       if ((rc = send(xsink, cname, mname, hdr.getBuffer(), hdr.strlen(), timeout_ms)))
          return rc;
 
-      if (size && data)
-         return send(xsink, cname, mname, (char*)data, size, timeout_ms);
-      else if (send_callback) {
+      if (send_callback) {
          assert(l);
          assert(!aborted || !(*aborted));
          return sendHttpChunkedWithCallback(xsink, cname, mname, *send_callback, *l, source, timeout_ms, aborted);
@@ -2641,13 +2995,15 @@ struct qore_socket_private {
 
       //printd(5, "QoreSocket::sendHTTPResponse() this: %p data: %p size: %ld send_callback: %p hdr: %s", this, data, size, send_callback, hdr.getBuffer());
 
+      // send the header and body together to avoid a separate system call and packet for the body
+      if (size && data)
+         return sendv(xsink, cname, mname, hdr.getBuffer(), hdr.strlen(), (const char*)data, size, timeout_ms);
+
       int rc;
       if ((rc = send(xsink, cname, mname, hdr.getBuffer(), hdr.strlen(), timeout_ms)))
          return rc;
 
-      if (size && data)
-         return send(xsink, cname, mname, (char*)data, size, timeout_ms);
-      else if (send_callback) {
+      if (send_callback) {
          assert(l);
          assert(!aborted || !(*aborted));
          return sendHttpChunkedWithCallback(xsink, cname, mname, *send_callback, *l, source, timeout_ms, aborted);
@@ -3129,7 +3485,8 @@ struct qore_socket_private {
                   cs.trim();
                   senc = cs.getBuffer();
                   //printd(5, "got encoding '%s' from request\n", senc);
-                  enc = QEM.findCreate(senc);
+                  if (!(flags & CHF_NO_ENCODING))
+                     enc = QEM.findCreate(senc);
 
                   if (info) {
                      qore_size_t len = cs.size();
@@ -3192,7 +3549,7 @@ struct qore_socket_private {
       }
 
       if ((flags & CHF_PROCESS)) {
-         if (!senc)
+         if (!senc && !(flags & CHF_NO_ENCODING))
             enc = QEM.findCreate("iso-8859-1");
          // according to RFC-2616 section 14.2, "If no Accept-Charset header is present, the default is that any character set is acceptable" so we will use utf-8
          if (info && !acceptcharset)
@@ -79,9 +79,9 @@ public:
 
    DLLLOCAL void check_char(qore_size_t i) {
       if (i >= allocated) {
-         qore_size_t d = i >> 2;
+         // grow geometrically so that repeated concatenation is amortized O(1)
+         qore_size_t d = i >> 1;
          allocated = i + (d < STR_CLASS_BLOCK ? STR_CLASS_BLOCK : d);
-         //allocated = i + STR_CLASS_BLOCK;
          allocated = (allocated / 16 + 1) * 16; // use complete cache line
          buf = (char*)realloc(buf, allocated * sizeof(char));
       }
@@ -519,11 +519,7 @@ public:
    DLLLOCAL int vsprintf(const char *fmt, va_list args) {
       size_t fmtlen = ::strlen(fmt);
       // ensure minimum space is free
-      if ((allocated - len - fmtlen) < MIN_SPRINTF_BUFSIZE) {
-         allocated += fmtlen + MIN_SPRINTF_BUFSIZE;
-         // resize buffer
-         buf = (char *)realloc(buf, allocated * sizeof(char));
-      }
+      check_char(len + fmtlen + MIN_SPRINTF_BUFSIZE);
       // set free buffer size
       qore_offset_t free = allocated - len;
 
@@ -544,8 +540,7 @@ public:
       if (i >= free) {
          //printf("DEBUG: vsnprintf() failed: i=%d allocated=" QSD " len=" QSD " buf=%p fmtlen=" QSD " (new=i+%d = %d)\n", i, allocated, len, buf, fmtlen, STR_CLASS_EXTRA, i + STR_CLASS_EXTRA);
          // resize buffer
-         allocated = len + i + STR_CLASS_EXTRA;
-         buf = (char *)realloc(buf, sizeof(char) * allocated);
+         check_char(len + i + STR_CLASS_EXTRA);
          *(buf + len) = '\0';
          return -1;
       }
@@ -37,11 +37,28 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <string>
+#include <atomic>
 
 #ifndef QORE_THREAD_STACK_SIZE
 #define QORE_THREAD_STACK_SIZE 1024*512
 #endif
 
+// default maximum number of idle native threads kept for reuse when Qore threads terminate
+#ifndef QORE_THREAD_CACHE_DEFAULT_MAX
+#define QORE_THREAD_CACHE_DEFAULT_MAX 16
+#endif
+
+// idle native threads in the thread cache exit after this number of milliseconds
+#ifndef QORE_THREAD_CACHE_IDLE_TIMEOUT
+#define QORE_THREAD_CACHE_IDLE_TIMEOUT 60000
+#endif
+
+// default sampling interval for the built-in profiler in milliseconds
+#ifndef QORE_PROFILE_DEFAULT_INTERVAL
+#define QORE_PROFILE_DEFAULT_INTERVAL 10
+#endif
+
 // the values here are subject to change and come from purely empirical testing
 #ifndef QORE_STACK_GUARD
 #ifdef CPU_X86_64
@@ -78,6 +95,7 @@ class ClosureParseEnvironment;
 class QoreClosureBase;
 struct ClosureVarValue;
 class VLock;
+class AbstractSmartLock;
 class ConstantEntry;
 class qore_ns_private;
 class qore_root_ns_private;
@@ -235,6 +253,9 @@ DLLLOCAL int purge_thread_resources_to_mark(ExceptionSink* xsink);
 DLLLOCAL void purge_thread_resources(ExceptionSink* xsink);
 DLLLOCAL void purge_pgm_thread_resources(const QoreProgram* pgm, ExceptionSink* xsink);
 DLLLOCAL void mark_thread_resources();
+// sets or removes a smart lock held exclusively by the current thread as a thread resource in O(1)
+DLLLOCAL void set_thread_lock_resource(AbstractSmartLock* asl);
+DLLLOCAL int remove_thread_lock_resource(AbstractSmartLock* asl);
 DLLLOCAL void beginParsing(const char* file, void* ps = NULL, const char* src = 0, int offset = 0);
 DLLLOCAL void* endParsing();
 DLLLOCAL Context* get_context_stack();
@@ -455,7 +476,8 @@ DLLLOCAL int get_thread_entry();
 // acquires TID 0 and sets up the signal thread entry, always returns 0
 DLLLOCAL int get_signal_thread_entry();
 DLLLOCAL void deregister_signal_thread();
-DLLLOCAL void register_thread(int tid, pthread_t ptid, QoreProgram* pgm, bool foreign = false);
+// if detached is true, the native thread has already been detached and will not be detached when the TID is released
+DLLLOCAL void register_thread(int tid, pthread_t ptid, QoreProgram* pgm, bool foreign = false, bool detached = false);
 DLLLOCAL void deregister_thread(int tid);
 DLLLOCAL void delete_signal_thread();
 
@@ -537,7 +559,8 @@ public:
 
 DLLLOCAL const QoreListNode* thread_get_implicit_args();
 
-DLLLOCAL LocalVarValue* thread_find_lvar(const char* id);
+// finds a local variable on the stack using and updating the slot index hint given
+DLLLOCAL LocalVarValue* thread_find_lvar(const char* id, std::atomic<int>& hint);
 
 // to get the current runtime object
 DLLLOCAL QoreObject* runtime_get_stack_object();
@@ -548,10 +571,16 @@ DLLLOCAL void runtime_get_object_and_class(QoreObject*& obj, const qore_class_pr
 DLLLOCAL bool runtime_in_object_method(const char* name, const QoreObject* o);
 
 class CodeContextHelperBase {
+   friend class QoreSamplingProfiler;
 private:
    const char* old_code;
    QoreObject* old_obj;
    const qore_class_private* old_class;
+   // the previous code context in the current thread; the chain is only read by the profiler in the same thread
+   const CodeContextHelperBase* old_ctx;
+   // the runtime location in the calling code
+   const char* call_file;
+   int call_line;
    bool do_ref;
    ExceptionSink* xsink;
 
@@ -871,6 +900,153 @@ public:
 
 DLLLOCAL extern QorePThreadAttr ta_default;
 
+class QoreNativeThread;
+
+// cache of idle native threads used to start Qore threads
+/** when a Qore thread terminates, its native thread waits for a new Qore thread to run instead of exiting, as
+    long as the cache is not full; idle threads exit after QORE_THREAD_CACHE_IDLE_TIMEOUT ms
+ */
+class QoreNativeThreadCache {
+public:
+   DLLLOCAL QoreNativeThreadCache() {
+   }
+
+   // runs f(arg) in an idle native thread or a new one; returns 0 for OK or the pthread_create() error code
+   DLLLOCAL int start(void* (*f)(void*), void* arg);
+
+   // sets the maximum number of idle threads and returns the old value; extra idle threads exit
+   DLLLOCAL unsigned setMax(unsigned n_max);
+
+   DLLLOCAL unsigned getMax() const {
+      AutoLocker al(l);
+      return max_idle;
+   }
+
+   // called when the library is shut down: makes all idle threads exit, prevents threads from being cached
+   // afterwards, and waits for all native threads that are not running a Qore thread to exit
+   DLLLOCAL void shutdown();
+
+   // locks the cache before fork() so that the child does not inherit a lock held by an idle thread
+   DLLLOCAL void preFork() {
+      l.lock();
+   }
+
+   // unlocks the cache after fork(); in the child process, idle threads do not exist and are forgotten
+   DLLLOCAL void postFork(bool child);
+
+   // called by a thread function started with start() before it signals that its Qore thread has terminated, so
+   // that shutdown() waits for the native thread
+   DLLLOCAL void finished();
+
+   // called by a native thread after running a Qore thread; returns true if a new thread function has been
+   // assigned or false if the native thread should exit
+   DLLLOCAL bool park(QoreNativeThread* nt);
+
+   // called by a native thread before it exits; deletes the native thread object
+   DLLLOCAL void exitThread(QoreNativeThread* nt);
+
+private:
+   mutable QoreThreadLock l;
+   // signaled when a native thread exits after shutdown() has been called
+   QoreCondition exit_cond;
+   // idle threads; the most recently used thread is reused first
+   std::vector<QoreNativeThread*> idle;
+   unsigned max_idle = QORE_THREAD_CACHE_DEFAULT_MAX;
+   // the number of native threads started by the cache that have not exited
+   unsigned native_count = 0;
+   // the number of native threads running a Qore thread
+   unsigned busy = 0;
+   // set when the library is shut down; no threads are cached afterwards
+   bool stopped = false;
+
+   // not implemented
+   DLLLOCAL QoreNativeThreadCache(const QoreNativeThreadCache&);
+   DLLLOCAL QoreNativeThreadCache& operator=(const QoreNativeThreadCache&);
+
+   // makes idle threads exit until only keep idle threads are left; must be called with the lock held
+   DLLLOCAL void releaseIntern(size_t keep);
+};
+
+DLLLOCAL extern QoreNativeThreadCache thread_cache;
+
+// built-in sampling profiler for Qore code
+/** a sampler thread advances a tick counter once per interval; each Qore thread takes a sample of its own call
+    stack after the first statement it completes after a tick, weighted by the number of ticks that have elapsed
+    since its last sample.  Call stacks are therefore only ever read by the thread that owns them, and the only
+    cost while the profiler is not running is a single check of an atomic flag per statement.
+
+    Samples are aggregated in folded stack format: one line per distinct stack, with frames separated by \c ";"
+    starting with the outermost frame, followed by a space and the number of samples
+ */
+class QoreSamplingProfiler {
+public:
+   DLLLOCAL QoreSamplingProfiler() {
+   }
+
+   // starts the profiler; returns 0 for OK, -1 for error (exception raised)
+   DLLLOCAL int start(int64 interval_ms, ExceptionSink* xsink);
+
+   // stops the profiler and returns the profile in folded stack format, or 0 if the profiler was not running
+   DLLLOCAL QoreStringNode* stop();
+
+   // returns the profile collected so far in folded stack format without stopping the profiler, or 0 if the profiler is not running
+   DLLLOCAL QoreStringNode* get() const;
+
+   DLLLOCAL bool active() const {
+      return running.load(std::memory_order_relaxed);
+   }
+
+   // called by Qore threads after executing a statement
+   DLLLOCAL void check() {
+      if (running.load(std::memory_order_relaxed))
+         sample();
+   }
+
+   // locks the profiler before fork() so that the child does not inherit a lock held by another thread
+   DLLLOCAL void preFork() {
+      sl.lock();
+      l.lock();
+   }
+
+   // unlocks the profiler after fork(); the sampler thread does not exist in the child process, so profiling is stopped there
+   DLLLOCAL void postFork(bool child);
+
+   // called by the sampler thread
+   DLLLOCAL void run();
+
+private:
+   typedef std::map<std::string, int64> sample_map_t;
+
+   mutable QoreThreadLock l;
+   // serializes start() and stop() so that each sampler thread is joined exactly once; never held by the
+   // sampler thread
+   QoreThreadLock sl;
+   QoreCondition cond;
+   // true while the profiler is running
+   std::atomic<bool> running = {false};
+   // the number of intervals elapsed; never reset so that stale per-thread values are always older than start_tick
+   std::atomic<int64> tick = {0};
+   // the tick value when the profiler was started
+   int64 start_tick = 0;
+   int64 interval = QORE_PROFILE_DEFAULT_INTERVAL;
+   // the sampler thread
+   pthread_t ptid;
+   // folded stack -> number of samples
+   sample_map_t samples;
+
+   // not implemented
+   DLLLOCAL QoreSamplingProfiler(const QoreSamplingProfiler&);
+   DLLLOCAL QoreSamplingProfiler& operator=(const QoreSamplingProfiler&);
+
+   // takes a sample of the current thread's call stack if a tick has elapsed since the last sample
+   DLLLOCAL void sample();
+
+   // returns the profile in folded stack format; must be called with the lock held
+   DLLLOCAL QoreStringNode* getIntern() const;
+};
+
+DLLLOCAL extern QoreSamplingProfiler qore_profiler;
+
 #ifdef QORE_MANAGE_STACK
 DLLLOCAL int check_stack(ExceptionSink* xsink);
 #endif
@@ -44,8 +44,11 @@ void AbstractSmartLock::cleanup(ExceptionSink *xsink) {
 
 void AbstractSmartLock::mark_and_push(int mtid, VLock *nvl) {
    nvl->push(this);
-   
-   tid = mtid;
+
+   // locks implementing the fast path have already set tid with a CAS; in this case it must not be overwritten
+   // in case the lock has been deleted in the meantime
+   int t = Lock_Unlocked;
+   tid.compare_exchange_strong(t, mtid);
    vl = nvl;
 }
 
@@ -60,22 +63,39 @@ void AbstractSmartLock::signalImpl() {
 }
 
 void AbstractSmartLock::release_and_signal() {
-   vl->pop(this);
-   
+   VLock* v = vl.exchange(nullptr);
+   if (v)
+      v->pop(this);
+
    if (tid >= 0)
       tid = Lock_Unlocked;
-   vl = 0;
    signalImpl();
 }
 
+void AbstractSmartLock::release_fast(int mtid) {
+   remove_thread_lock_resource(this);
+
+   // only one of the owner and the destructor gets the lock list to remove the lock from
+   VLock* v = vl.exchange(nullptr);
+   if (v)
+      v->pop(this);
+
+   // if the CAS fails, the lock has been deleted in another thread, which also woke up any waiting threads
+   int t = mtid;
+   if (tid.compare_exchange_strong(t, Lock_Unlocked) && waiting) {
+      AutoLocker al(&asl_lock);
+      signalImpl();
+   }
+}
+
 void AbstractSmartLock::grab_intern(int mtid, VLock *nvl) {
    printd(5, "AbstractSmartLock::grab_intern() (%s) this: %p grabbed lock (nvl: %p)\n", getName(), this, nvl);
    mark_and_push(mtid, nvl);
-   set_thread_resource(this);
+   set_thread_lock_resource(this);
 }
-      
+
 void AbstractSmartLock::release_intern() {
-   remove_thread_resource(this);
+   remove_thread_lock_resource(this);
    release_and_signal();
 }
 
@@ -85,20 +105,22 @@ void AbstractSmartLock::destructorImpl(ExceptionSink *xsink) {
 void AbstractSmartLock::destructor(ExceptionSink *xsink) {
    AutoLocker al(&asl_lock);
    destructorImpl(xsink);
-   if (tid >= 0) {
-      vl->pop(this);
-      
+   int t = tid.exchange(Lock_Deleted);
+   if (t >= 0) {
+      VLock* v = vl.exchange(nullptr);
+      if (v)
+         v->pop(this);
+
       int mtid = gettid();
-      if (mtid == tid) {
+      if (mtid == t) {
 	 xsink->raiseException("LOCK-ERROR", "TID %d deleted %s object while holding the lock", mtid, getName());
-	 remove_thread_resource(this);
+	 remove_thread_lock_resource(this);
       }
       else
-	 xsink->raiseException("LOCK-ERROR", "TID %d deleted %s object while TID %d was holding the lock", mtid, getName(), tid);
+	 xsink->raiseException("LOCK-ERROR", "TID %d deleted %s object while TID %d was holding the lock", mtid, getName(), t);
 
       signalAllImpl();
    }
-   tid = Lock_Deleted;
 }
 
 // grab return values: 
@@ -115,10 +137,18 @@ return grabInternImpl(mtid);
 
 int AbstractSmartLock::grab(ExceptionSink *xsink, int64 timeout_ms) {
    int mtid = gettid();
-   
    VLock *nvl = getVLock();
+
+   // asl_lock and deadlock detection are only needed if the lock is contended
+   int rc;
+   if (grabFastImpl(mtid, rc)) {
+      if (!rc)
+         grab_intern(mtid, nvl);
+      return rc;
+   }
+
    AutoLocker al(&asl_lock);
-   int rc = grabImpl(mtid, nvl, xsink, timeout_ms);
+   rc = grabImpl(mtid, nvl, xsink, timeout_ms);
    if (!rc)
       grab_intern(mtid, nvl);
    return rc;
@@ -127,8 +157,16 @@ int AbstractSmartLock::grab(ExceptionSink *xsink, int64 timeout_ms) {
 int AbstractSmartLock::tryGrab() {
    int mtid = gettid();
    VLock *nvl = getVLock();
+
+   int rc;
+   if (grabFastImpl(mtid, rc)) {
+      if (!rc)
+         grab_intern(mtid, nvl);
+      return rc;
+   }
+
    AutoLocker al(&asl_lock);
-   int rc = tryGrabImpl(mtid, nvl);
+   rc = tryGrabImpl(mtid, nvl);
    if (!rc)
       grab_intern(mtid, nvl);
    return rc;
@@ -143,8 +181,12 @@ int AbstractSmartLock::release() {
 }
 
 int AbstractSmartLock::release(ExceptionSink *xsink) {
+   int rc;
+   if (releaseFastImpl(gettid(), rc))
+      return rc;
+
    AutoLocker al(&asl_lock);
-   int rc = releaseImpl(xsink);
+   rc = releaseImpl(xsink);
    if (!rc)
       release_intern();
    return rc;
@@ -163,9 +205,10 @@ int AbstractSmartLock::extern_wait(QoreCondition *cond, ExceptionSink *xsink, in
 int AbstractSmartLock::verify_wait_unlocked(int mtid, ExceptionSink *xsink) {
    if (tid == mtid)
       return 0;
-   if (tid < 0)
+   int t = tid;
+   if (t < 0)
       xsink->raiseException("WAIT-ERROR", "wait() called with unlocked %s argument", getName());
    else
-      xsink->raiseException("WAIT-ERROR", "TID %d called wait() with %s lock argument held by TID %d", mtid, getName(), tid);
+      xsink->raiseException("WAIT-ERROR", "TID %d called wait() with %s lock argument held by TID %d", mtid, getName(), t);
    return -1;
 }
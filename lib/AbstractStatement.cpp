@@ -51,7 +51,11 @@ int AbstractStatement::exec(QoreValue& return_value, ExceptionSink *xsink) {
    pthread_testcancel();
 
    QoreProgramBlockParseOptionHelper bh(pwo.parse_options);
-   return execImpl(return_value, xsink);
+   int rc = execImpl(return_value, xsink);
+
+   // take a profiling sample if necessary while the runtime location still refers to this statement
+   qore_profiler.check();
+   return rc;
 }
 
 int AbstractStatement::parseInit(LocalVar *oflag, int pflag) {
@@ -0,0 +1,452 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  CsvRecordBuilder.cpp
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#include <qore/Qore.h>
+#include "qore/intern/CsvRecordBuilder.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the following helpers implement the same checks as Util::is_int(), Util::is_float(), and Util::is_number()
+static const char* csv_skip_ws(const char* p) {
+   while (isspace(*p))
+      ++p;
+   return p;
+}
+
+static const char* csv_skip_digits(const char* p) {
+   while (isdigit(*p))
+      ++p;
+   return p;
+}
+
+// same semantics as <string>::intp(): the first character, or the second if the first is '-', must be a digit
+static bool csv_intp(const QoreString* str) {
+   if (str->empty())
+      return false;
+   const char* p = str->getBuffer();
+   char c = *p == '-' ? p[1] : *p;
+   return isdigit(c) ? true : false;
+}
+
+// matches: \d+\.\d*(e[-+]?\d+)? | \.\d+(e[-+]?\d+)? | \d+e[-+]?\d+
+// returns a pointer to the first character after the float or 0 if there was no match
+static const char* csv_match_float_body(const char* p) {
+   const char* d = csv_skip_digits(p);
+   bool exp_required = false;
+   if (*d == '.') {
+      const char* f = csv_skip_digits(d + 1);
+      // a leading dot requires at least one digit after it
+      if (d == p && f == d + 1)
+         return 0;
+      p = f;
+   }
+   else {
+      if (d == p)
+         return 0;
+      exp_required = true;
+      p = d;
+   }
+
+   if (*p == 'e') {
+      const char* e = p + 1;
+      if (*e == '-' || *e == '+')
+         ++e;
+      const char* ed = csv_skip_digits(e);
+      if (ed != e)
+         return ed;
+   }
+
+   return exp_required ? 0 : p;
+}
+
+static bool csv_is_pure_int(const char* p) {
+   p = csv_skip_ws(p);
+   if (*p == '-' || *p == '+')
+      ++p;
+   const char* d = csv_skip_digits(p);
+   if (d == p)
+      return false;
+   return !*csv_skip_ws(d);
+}
+
+static bool csv_is_pure_float(const char* p) {
+   p = csv_skip_ws(p);
+   if (*p == '-' || *p == '+')
+      ++p;
+   p = csv_match_float_body(p);
+   return p && !*csv_skip_ws(p);
+}
+
+static bool csv_is_int(const char* p) {
+   if (csv_is_pure_int(p))
+      return true;
+   if (!csv_is_pure_float(p))
+      return false;
+   double f = q_strtod(p);
+   return f == floor(f);
+}
+
+static bool csv_is_float(const char* p) {
+   return csv_is_pure_float(p) || csv_is_int(p);
+}
+
+static bool csv_is_number(const char* p) {
+   const char* s = csv_skip_ws(p);
+   if (*s == '-' || *s == '+')
+      ++s;
+   const char* e = csv_match_float_body(s);
+   if (!e) {
+      e = csv_skip_digits(s);
+      if (e == s)
+         e = 0;
+   }
+   if (e && *e == 'n' && !*csv_skip_ws(e + 1))
+      return true;
+   return csv_is_float(p);
+}
+
+static int csv_get_type(const char* str, csv_field_type_e& type, bool& or_nothing) {
+   or_nothing = (*str == '*');
+   if (or_nothing)
+      ++str;
+
+   if (!strcmp(str, "string"))
+      type = CFT_STRING;
+   else if (!strcmp(str, "int"))
+      type = CFT_INT;
+   else if (!strcmp(str, "float"))
+      type = CFT_FLOAT;
+   else if (!strcmp(str, "number"))
+      type = CFT_NUMBER;
+   else if (!strcmp(str, "date"))
+      type = CFT_DATE;
+   else
+      return -1;
+   return 0;
+}
+
+static const char* csv_type_name(csv_field_type_e type) {
+   switch (type) {
+      case CFT_INT: return "int";
+      case CFT_FLOAT: return "float";
+      case CFT_NUMBER: return "number";
+      case CFT_DATE: return "date";
+      default: break;
+   }
+   return "string";
+}
+
+static void csv_field_value_error(csv_field_type_e type, const QoreStringNode* val, ExceptionSink* xsink) {
+   QoreNodeAsStringHelper str(val, FMT_YAML_SHORT, xsink);
+   if (*xsink)
+      return;
+   xsink->raiseException("FIELD-VALUE-ERROR", "invalid %s value: %s", csv_type_name(type), str->getBuffer());
+}
+
+bool CsvFieldRule::match(const AbstractQoreNode* v, ExceptionSink* xsink) const {
+   if (regex) {
+      if (!v || v->getType() != NT_STRING)
+         return false;
+      return regex->exec(reinterpret_cast<const QoreStringNode*>(v), xsink);
+   }
+
+   // special care about the int type: 0 == "000" should match
+   if (get_node_type(value) == NT_INT) {
+      if (!v || v->getType() != NT_STRING)
+         return false;
+      const QoreStringNode* str = reinterpret_cast<const QoreStringNode*>(v);
+      if (!csv_intp(str))
+         return false;
+      return str->getAsBigInt() == reinterpret_cast<const QoreBigIntNode*>(value)->val;
+   }
+
+   if (!v)
+      return is_nothing(value);
+   return v->is_equal_soft(value, xsink);
+}
+
+QoreListNode* CsvRecordBuilder::split(const QoreString* line, ExceptionSink* xsink) {
+   const QoreEncoding* enc = line->getEncoding();
+   // convert the separator and quote strings only when the input encoding changes
+   if (enc != last_enc) {
+      TempEncodingHelper tsep(sep, enc, xsink);
+      if (*xsink)
+         return nullptr;
+      TempEncodingHelper tquote(quote, enc, xsink);
+      if (*xsink)
+         return nullptr;
+      esep.set(**tsep);
+      equote.set(**tquote);
+      last_enc = enc;
+   }
+
+   return split_with_quote_intern(esep.getBuffer(), esep.strlen(), equote.getBuffer(), equote.strlen(), line, trim, xsink);
+}
+
+int CsvRecordBuilder::setRecord(const QoreString* type, const QoreHashNode* spec, const QoreListNode* order, ExceptionSink* xsink) {
+   csv_field_list_t fl;
+
+   ConstListIterator li(order);
+   while (li.next()) {
+      const AbstractQoreNode* n = li.getValue();
+      if (get_node_type(n) != NT_STRING) {
+         xsink->raiseException("CSVRECORDBUILDER-ERROR", "field list element %d for record '%s' is type '%s'; expecting 'string'", (int)li.index(), type->getBuffer(), get_type_name(n));
+         break;
+      }
+      const char* name = reinterpret_cast<const QoreStringNode*>(n)->getBuffer();
+
+      const QoreHashNode* fh = reinterpret_cast<const QoreHashNode*>(spec->getKeyValue(name));
+      if (get_node_type(fh) != NT_HASH) {
+         xsink->raiseException("CSVRECORDBUILDER-ERROR", "field '%s' in record '%s' has no field description hash", name, type->getBuffer());
+         break;
+      }
+
+      bool found;
+      int64 idx = fh->getKeyAsBigInt("idx", found);
+      if (!found || idx < 0) {
+         xsink->raiseException("CSVRECORDBUILDER-ERROR", "field '%s' in record '%s' has no valid \"idx\" key", name, type->getBuffer());
+         break;
+      }
+
+      csv_field_type_e ft = CFT_STRING;
+      bool or_nothing = true;
+      const AbstractQoreNode* tn = fh->getKeyValue("type");
+      if (tn) {
+         if (tn->getType() != NT_STRING || csv_get_type(reinterpret_cast<const QoreStringNode*>(tn)->getBuffer(), ft, or_nothing)) {
+            QoreNodeAsStringHelper str(tn, FMT_NONE, xsink);
+            xsink->raiseException("CSV-TYPE-ERROR", "unknown field type '%s' for field '%s' in record '%s'", str->getBuffer(), name, type->getBuffer());
+            break;
+         }
+      }
+
+      fl.push_back(CsvFieldSpec(name, (size_t)idx, ft, or_nothing));
+      CsvFieldSpec& fs = fl.back();
+
+      const AbstractQoreNode* v = fh->getKeyValue("format");
+      if (v && v->getType() == NT_STRING)
+         fs.format = new QoreString(*reinterpret_cast<const QoreStringNode*>(v));
+
+      v = fh->getKeyValue("timezone");
+      if (v && v->getType() == NT_OBJECT) {
+         SimpleRefHolder<TimeZoneData> tz(reinterpret_cast<TimeZoneData*>(reinterpret_cast<const QoreObject*>(v)->getReferencedPrivateData(CID_TIMEZONE, xsink)));
+         if (*xsink)
+            break;
+         if (tz) {
+            fs.zone = tz->get();
+            fs.has_zone = true;
+         }
+      }
+
+      v = fh->getKeyValue("code");
+      if (v && (v->getType() == NT_FUNCREF || v->getType() == NT_RUNTIME_CLOSURE))
+         fs.code = reinterpret_cast<const ResolvedCallReferenceNode*>(v)->refRefSelf();
+   }
+
+   if (*xsink) {
+      clearRecord(fl, xsink);
+      return -1;
+   }
+
+   csv_record_map_t::iterator i = rmap.lower_bound(type->getBuffer());
+   if (i != rmap.end() && i->first == type->getBuffer()) {
+      clearRecord(i->second, xsink);
+      i->second.swap(fl);
+   }
+   else
+      rmap.insert(i, csv_record_map_t::value_type(type->getBuffer(), fl));
+   return 0;
+}
+
+int CsvRecordBuilder::setRules(const QoreHashNode* rules, ExceptionSink* xsink) {
+   clearRules(xsink);
+
+   ConstHashIterator hi(rules);
+   while (hi.next()) {
+      size_t cnt = (size_t)strtoll(hi.getKey(), 0, 10);
+      const QoreHashNode* rh = reinterpret_cast<const QoreHashNode*>(hi.getValue());
+      if (get_node_type(rh) != NT_HASH)
+         continue;
+
+      csv_record_rule_list_t& rl = rule_map[cnt];
+
+      ConstHashIterator ri(rh);
+      while (ri.next()) {
+         rl.push_back(CsvRecordRule(ri.getKey()));
+         CsvRecordRule& rr = rl.back();
+
+         const QoreListNode* l = reinterpret_cast<const QoreListNode*>(ri.getValue());
+         if (get_node_type(l) != NT_LIST)
+            continue;
+
+         ConstListIterator li(l);
+         while (li.next()) {
+            const QoreHashNode* fh = reinterpret_cast<const QoreHashNode*>(li.getValue());
+            if (get_node_type(fh) != NT_HASH)
+               continue;
+
+            bool found;
+            int64 idx = fh->getKeyAsBigInt("idx", found);
+            rr.rules.push_back(CsvFieldRule(idx < 0 ? 0 : (size_t)idx));
+            CsvFieldRule& fr = rr.rules.back();
+
+            const AbstractQoreNode* v = fh->getKeyValue("regex");
+            if (v && v->getType() == NT_STRING) {
+               // compile the regular expression once instead of for every line
+               fr.regex = new QoreRegex(*reinterpret_cast<const QoreStringNode*>(v), 0, xsink);
+               if (*xsink)
+                  return -1;
+            }
+            else {
+               v = fh->getKeyValue("value");
+               fr.value = v ? v->refSelf() : nullptr;
+            }
+         }
+      }
+   }
+
+   return 0;
+}
+
+QoreStringNode* CsvRecordBuilder::matchRule(const QoreListNode* values, ExceptionSink* xsink) const {
+   csv_rule_map_t::const_iterator i = rule_map.find(values->size());
+   if (i == rule_map.end())
+      return nullptr;
+
+   for (auto& rr : i->second) {
+      bool found = true;
+      for (auto& fr : rr.rules) {
+         bool m = fr.match(values->retrieve_entry(fr.idx), xsink);
+         if (*xsink)
+            return nullptr;
+         if (!m) {
+            found = false;
+            break;
+         }
+      }
+      if (found)
+         return new QoreStringNode(rr.type.c_str());
+   }
+
+   return nullptr;
+}
+
+AbstractQoreNode* CsvRecordBuilder::convert(const CsvFieldSpec& fs, const QoreStringNode* val, ExceptionSink* xsink) const {
+   // if it's an "or nothing" type and there is no value, then return nothing
+   if (fs.or_nothing && (!val || val->empty()))
+      return nullptr;
+
+   switch (fs.type) {
+      case CFT_INT: {
+         if (!val || !csv_is_int(val->getBuffer())) {
+            csv_field_value_error(fs.type, val, xsink);
+            return nullptr;
+         }
+         return new QoreBigIntNode(strtoll(val->getBuffer(), 0, 10));
+      }
+
+      case CFT_FLOAT: {
+         if (!val || !csv_is_float(val->getBuffer())) {
+            csv_field_value_error(fs.type, val, xsink);
+            return nullptr;
+         }
+         return new QoreFloatNode(q_strtod(val->getBuffer()));
+      }
+
+      case CFT_NUMBER: {
+         if (!val || !csv_is_number(val->getBuffer())) {
+            csv_field_value_error(fs.type, val, xsink);
+            return nullptr;
+         }
+         return new QoreNumberNode(val->getBuffer());
+      }
+
+      case CFT_DATE: {
+         if (!val || val->empty())
+            return DateTimeNode::makeAbsolute(nullptr, (int64)0);
+
+         const AbstractQoreZoneInfo* tz = fs.has_zone ? fs.zone : (has_zone ? zone : currentTZ());
+         const QoreString* fmt = fs.format ? fs.format : date_format;
+         if (fmt)
+            return make_date_with_mask(tz, *val, *fmt, xsink);
+         return new DateTimeNode(tz, val->getBuffer());
+      }
+
+      default:
+         break;
+   }
+
+   return val ? val->stringRefSelf() : nullptr;
+}
+
+QoreHashNode* CsvRecordBuilder::build(const QoreString* type, const QoreListNode* values, ExceptionSink* xsink) const {
+   csv_record_map_t::const_iterator i = rmap.find(type->getBuffer());
+   if (i == rmap.end()) {
+      xsink->raiseException("CSVRECORDBUILDER-ERROR", "record type '%s' has not been defined", type->getBuffer());
+      return nullptr;
+   }
+
+   ReferenceHolder<QoreHashNode> rec(new QoreHashNode, xsink);
+   ReferenceHolder<QoreListNode> l(new QoreListNode, xsink);
+
+   for (auto& fs : i->second) {
+      const AbstractQoreNode* n = values->retrieve_entry(fs.idx);
+      if (n && n->getType() != NT_STRING) {
+         xsink->raiseException("CSVRECORDBUILDER-ERROR", "value %d for field '%s' is type '%s'; expecting 'string'", (int)fs.idx, fs.name.c_str(), get_type_name(n));
+         return nullptr;
+      }
+
+      // first apply type transformations
+      ReferenceHolder<AbstractQoreNode> val(convert(fs, reinterpret_cast<const QoreStringNode*>(n), xsink), xsink);
+      if (*xsink)
+         return nullptr;
+
+      // execute any callable value on the processed value
+      if (fs.code) {
+         ReferenceHolder<QoreListNode> args(new QoreListNode, xsink);
+         args->push(val.release());
+         ValueHolder rv(fs.code->execValue(*args, xsink), xsink);
+         if (*xsink)
+            return nullptr;
+         val = rv.release().takeNode();
+      }
+
+      l->push(val ? val->refSelf() : nullptr);
+      rec->setKeyValue(fs.name.c_str(), val.release(), xsink);
+   }
+
+   QoreHashNode* h = new QoreHashNode;
+   h->setKeyValue("spec_fields", rec.release(), nullptr);
+   h->setKeyValue("all_fields", l.release(), nullptr);
+   return h;
+}
@@ -340,6 +340,17 @@ void DateTime::getInfo(qore_tm& info) const {
    i.copyTo(info);
 }
 
+void DateTime::getInfo(const AbstractQoreZoneInfo* zone, const int64* epoch, size_t count, qore_tm* info) {
+   qore_time_info i;
+   for (size_t j = 0; j < count; ++j) {
+      const char* zname;
+      bool isdst;
+      int offset = AbstractQoreZoneInfo::getUTCOffset(zone, epoch[j], isdst, zname);
+      i.set(epoch[j], 0, offset, isdst, zname, zone);
+      i.copyTo(info[j]);
+   }
+}
+
 void DateTime::setZone(const AbstractQoreZoneInfo* n_zone) {
    priv->setZone(n_zone);
 }
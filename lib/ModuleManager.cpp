@@ -55,6 +55,8 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <stdarg.h>
+#include <dirent.h>
+#include <time.h>
 
 #include <string>
 #include <map>
@@ -64,6 +66,11 @@
 static const qore_mod_api_compat_s qore_mod_api_list_l[] = { {0, 20}, {0, 19}, {0, 18}, {0, 17}, {0, 16}, {0, 15}, {0, 14}, {0, 13}, {0, 12}, {0, 11}, {0, 10}, {0, 9}, {0, 8}, {0, 7}, {0, 6}, {0, 5} };
 #define QORE_MOD_API_LEN (sizeof(qore_mod_api_list_l)/sizeof(struct qore_mod_api_compat_s))
 
+// module directory listings are only cached on platforms where file name lookups are case-sensitive by default
+#if !defined(_Q_WINDOWS) && !defined(DARWIN)
+#define QORE_MODULE_DIR_INDEX 1
+#endif
+
 // public symbols
 const qore_mod_api_compat_s* qore_mod_api_list = qore_mod_api_list_l;
 const unsigned qore_mod_api_list_len = QORE_MOD_API_LEN;
@@ -349,8 +356,8 @@ void QoreUserModule::addToProgramImpl(QoreProgram* tpgm, ExceptionSink& xsink) c
       return;
    }
 
-   // commit all module changes
-   qore_root_ns_private::copyMergeCommittedNamespace(*rns, *(pgm->getRootNS()));
+   // commit all module changes; with %share-module-classes, immutable classes are referenced instead of copied
+   qore_root_ns_private::copyMergeCommittedNamespace(*rns, *(pgm->getRootNS()), (bool)(tpgm->getParseOptions64() & PO_SHARE_MODULE_CLASSES));
    qore_program_private::addUserFeature(*tpgm, name.getBuffer());
    //tpgm->addUserFeature(name.getBuffer());
 
@@ -567,6 +574,73 @@ void QoreModuleManager::reinjectModule(QoreAbstractModule* mi) {
    addModule(mi);
 }
 
+// returns true if the given file exists in the given module directory and sets the file's path
+/** if dir_index is not 0, it's used to rule out nonexistent files without a stat() call
+ */
+static bool module_file_exists(const std::string& dir, const strset_t* dir_index, const QoreString& fn, QoreString& path) {
+   if (dir_index && dir_index->find(fn.getBuffer()) == dir_index->end())
+      return false;
+
+   path.clear();
+   path.sprintf("%s" QORE_DIR_SEP_STR "%s", dir.c_str(), fn.getBuffer());
+
+   struct stat sb;
+   return !stat(path.getBuffer(), &sb);
+}
+
+const strset_t* QoreModuleManager::getModuleDirIndex(const std::string& dir) {
+#ifdef QORE_MODULE_DIR_INDEX
+   // an empty index for nonexistent directories
+   static const strset_t empty_index;
+
+   struct stat sb;
+   if (stat(dir.c_str(), &sb)) {
+      int err = errno;
+      mod_dir_index.erase(dir);
+      return err == ENOENT || err == ENOTDIR ? &empty_index : 0;
+   }
+   if (!S_ISDIR(sb.st_mode)) {
+      mod_dir_index.erase(dir);
+      return &empty_index;
+   }
+
+   mod_dir_index_map_t::iterator i = mod_dir_index.find(dir);
+   if (i != mod_dir_index.end() && i->second.mtime == sb.st_mtime && !i->second.racy)
+      return &i->second.files;
+
+   DIR* dp = opendir(dir.c_str());
+   if (!dp) {
+      if (i != mod_dir_index.end())
+         mod_dir_index.erase(i);
+      return 0;
+   }
+   ON_BLOCK_EXIT(closedir, dp);
+
+   if (i == mod_dir_index.end())
+      i = mod_dir_index.insert(mod_dir_index_map_t::value_type(dir, ModuleDirIndex())).first;
+   else
+      i->second.files.clear();
+
+   i->second.mtime = sb.st_mtime;
+   i->second.racy = time(0) <= sb.st_mtime;
+
+   while (struct dirent* de = readdir(dp))
+      i->second.files.insert(de->d_name);
+
+   //printd(5, "QoreModuleManager::getModuleDirIndex() indexed '%s': %d files\n", dir.c_str(), (int)i->second.files.size());
+   return &i->second.files;
+#else
+   return 0;
+#endif
+}
+
+QoreAbstractModule* QoreModuleManager::findParsedUserModule(const char* path, const char* feature, time_t mtime, int64 size) {
+   QoreAbstractModule* mi = findModuleUnlocked(feature);
+   if (!mi || !mi->isUser() || mi->isPrivate() || !mi->isPath(path))
+      return 0;
+   return static_cast<QoreUserModule*>(mi)->fileUnchanged(mtime, size) ? mi : 0;
+}
+
 void QoreModuleManager::loadModuleIntern(ExceptionSink& xsink, const char* name, QoreProgram* pgm, bool reexport, mod_op_e op, version_list_t* version, const char* src, QoreProgram* mpgm, unsigned load_opt) {
    assert(!version || (version && op != MOD_OP_NONE));
 
@@ -727,24 +801,27 @@ void QoreModuleManager::loadModuleIntern(ExceptionSink& xsink, const char* name,
 
    // otherwise, try to find module in the module path
    QoreString str;
-   struct stat sb;
+   QoreString fn;
 
    strdeque_t::const_iterator w = moduleDirList.begin();
    while (w != moduleDirList.end()) {
+      // get the directory listing once for all possible module file names
+      const strset_t* dir_index = getModuleDirIndex(*w);
+
       // try to find module with supported api tags
       for (unsigned ai = 0; ai <= qore_mod_api_list_len; ++ai) {
-         // build path to binary module
-         str.clear();
-         str.sprintf("%s" QORE_DIR_SEP_STR "%s", (*w).c_str(), name);
+         // build binary module file name
+         fn.clear();
+         fn.concat(name);
 
          // make new extension string
          if (ai < qore_mod_api_list_len)
-            str.sprintf("-api-%d.%d.qmod", qore_mod_api_list[ai].major, qore_mod_api_list[ai].minor);
+            fn.sprintf("-api-%d.%d.qmod", qore_mod_api_list[ai].major, qore_mod_api_list[ai].minor);
          else
-            str.concat(".qmod");
+            fn.concat(".qmod");
 
-         //printd(5, "ModuleManager::loadModule(%s) trying binary module: %s\n", name, str.getBuffer());
-         if (!stat(str.getBuffer(), &sb)) {
+         //printd(5, "ModuleManager::loadModule(%s) trying binary module: %s\n", name, fn.getBuffer());
+         if (module_file_exists(*w, dir_index, fn, str)) {
             printd(5, "ModuleManager::loadModule(%s) found binary module: %s\n", name, str.getBuffer());
             if (mpgm) {
                xsink.raiseException("LOAD-MODULE-ERROR", "cannot load a binary module with a Program container");
@@ -762,12 +839,12 @@ void QoreModuleManager::loadModuleIntern(ExceptionSink& xsink, const char* name,
             return;
          }
 
-         // build path to user module
-         str.clear();
-         str.sprintf("%s" QORE_DIR_SEP_STR "%s.qm", (*w).c_str(), name);
+         // build user module file name
+         fn.clear();
+         fn.sprintf("%s.qm", name);
 
-         //printd(5, "ModuleManager::loadModule(%s) trying user module: %s\n", name, str.getBuffer());
-         if (!stat(str.getBuffer(), &sb)) {
+         //printd(5, "ModuleManager::loadModule(%s) trying user module: %s\n", name, fn.getBuffer());
+         if (module_file_exists(*w, dir_index, fn, str)) {
             // see if this is a relative path; if so normalize it; we cannot send a relative path to loadUserModuleFromPath()
             // since it will try to normalize the path using the current program's directory as the cwd
             if (!q_absolute_path(str.getBuffer()))
@@ -990,6 +1067,22 @@ QoreAbstractModule* QoreModuleManager::loadUserModuleFromPath(ExceptionSink& xsi
    }
    const char* td = p ? p->parseGetScriptDir() : 0;
 
+   // get the module file's modification time and size before parsing so that later changes are detected
+   QoreString npath(path);
+   q_normalize_path(npath, td);
+   struct stat sb;
+   bool have_stat = !stat(npath.getBuffer(), &sb);
+
+   // a module already parsed from the same unchanged file is used as-is if it is not being loaded into a specific
+   // Program container, in which case the new parse would only be discarded in setupUserModule()
+   if (have_stat && !pgm && !(load_opt & (QMLO_INJECT | QMLO_REINJECT | QMLO_PRIVATE | QMLO_RELOAD))) {
+      QoreAbstractModule* omi = findParsedUserModule(npath.getBuffer(), feature, sb.st_mtime, sb.st_size);
+      if (omi) {
+         printd(5, "QoreModuleManager::loadUserModuleFromPath() '%s': using module '%s' already parsed\n", npath.getBuffer(), feature);
+         return omi;
+      }
+   }
+
    if (pgm)
       qore_program_private::forceReplaceParseOptions(*pgm, po);
    else
@@ -1002,6 +1095,8 @@ QoreAbstractModule* QoreModuleManager::loadUserModuleFromPath(ExceptionSink& xsi
 
    td = mi->getFileName();
    //printd(5, "QoreModuleManager::loadUserModuleFromPath() normalized path: '%s'\n", td);
+   if (have_stat)
+      mi->setFileInfo(sb.st_mtime, sb.st_size);
 
    if (module_load_check(td)) {
       xsink.raiseException("LOAD-MODULE-ERROR", "cannot load user module '%s'; recursive module dependency detected", td);
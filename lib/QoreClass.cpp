@@ -508,6 +508,7 @@ qore_class_private::qore_class_private(QoreClass* n_cls, std::string&& nme, int6
      final(false),
      inject(false),
      gate_access(false),
+     shared(false),
      domain(dom),
      num_methods(0),
      num_user_methods(0),
@@ -551,6 +552,7 @@ qore_class_private::qore_class_private(const qore_class_private& old, QoreClass*
      final(old.final),
      inject(old.inject),
      gate_access(old.gate_access),
+     shared(false),
      domain(old.domain),
      num_methods(old.num_methods),
      num_user_methods(old.num_user_methods),
@@ -1159,6 +1161,10 @@ QoreObject* qore_class_private::execConstructor(const AbstractQoreFunctionVarian
 
 void qore_class_private::parseCommit() {
    //printd(5, "qore_class_private::parseCommit() %s this: %p cls: %p hm.size: %d\n", name.c_str(), this, cls, hm.size());
+   // classes shared from user modules are committed in the module's Program and cannot have changes
+   if (shared)
+      return;
+
    if (parse_init_called)
       parse_init_called = false;
 
@@ -3899,7 +3905,7 @@ QoreListNode* QoreClass::getStaticMethodList() const {
 }
 
 void qore_class_private::parseInitPartial() {
-   if (parse_init_partial_called)
+   if (parse_init_partial_called || shared)
       return;
 
    initialize();
@@ -3979,6 +3985,10 @@ void qore_class_private::parseInitPartialIntern() {
 }
 
 void qore_class_private::parseInit() {
+   // classes shared from user modules are already initialized and may be in use by other Programs
+   if (shared)
+      return;
+
    // make sure initialize() is called first
    initialize();
 
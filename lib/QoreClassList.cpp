@@ -46,6 +46,7 @@ void QoreClassList::remove(hm_qc_t::iterator i) {
    QoreClass* qc = i->second;
    //printd(5, "QCL::remove() this: %p '%s' (%p)\n", this, qc->getName(), qc);
    hm.erase(i);
+   shared.erase(qc);
    qore_class_private::get(*qc)->deref();
 }
 
@@ -54,6 +55,7 @@ void QoreClassList::deleteAll() {
       qore_class_private::get(*i->second)->deref();
 
    hm.clear();
+   shared.clear();
 }
 
 QoreClassList::~QoreClassList() {
@@ -91,7 +93,7 @@ QoreClassList::QoreClassList(const QoreClassList& old, int64 po, qore_ns_private
    for (hm_qc_t::const_iterator i = old.hm.begin(), e = old.hm.end(); i != e; ++i) {
       if (!i->second->isSystem()) {
          //printd(5, "QoreClassList::QoreClassList() this: %p c: %p '%s' po & PO_NO_INHERIT_USER_CLASSES: %s pub: %s\n", this, i->second, i->second->getName(), po & PO_NO_INHERIT_USER_CLASSES ? "true": "false", qore_class_private::isPublic(*i->second) ? "true": "false");
-         if (po & PO_NO_INHERIT_USER_CLASSES || !qore_class_private::isPublic(*i->second))
+         if (po & PO_NO_INHERIT_USER_CLASSES || !qore_class_private::isPublic(*i->second) || old.isShared(i->second))
             continue;
       }
       else
@@ -103,9 +105,10 @@ QoreClassList::QoreClassList(const QoreClassList& old, int64 po, qore_ns_private
    }
 }
 
-void QoreClassList::mergeUserPublic(const QoreClassList& old, qore_ns_private* ns) {
+void QoreClassList::mergeUserPublic(const QoreClassList& old, qore_ns_private* ns, bool share) {
    for (hm_qc_t::const_iterator i = old.hm.begin(), e = old.hm.end(); i != e; ++i) {
-      if (!qore_class_private::isUserPublic(*i->second))
+      // classes shared from another module are not exported; copies are not public either
+      if (!qore_class_private::isUserPublic(*i->second) || old.isShared(i->second))
          continue;
 
       QoreClass* qc = find(i->first);
@@ -114,8 +117,21 @@ void QoreClassList::mergeUserPublic(const QoreClassList& old, qore_ns_private* n
          continue;
       }
 
-      qc = new QoreClass(*i->second);
-      qore_class_private::setNamespace(qc, ns);
+      qore_class_private* qcp = qore_class_private::get(*i->second);
+      // committed classes in a module's Program are not modified after the module has been loaded, so they can be
+      // referenced directly; classes with static variables are copied so that the importing Program cannot access
+      // the module's static variable values directly
+      if (share && !qcp->hasStaticVarsInHierarchy()) {
+         //printd(5, "QoreClassList::mergeUserPublic() this: %p sharing %p '%s'\n", this, i->second, i->first);
+         qcp->ref();
+         qcp->shared = true;
+         qc = i->second;
+         shared.insert(qc);
+      }
+      else {
+         qc = new QoreClass(*i->second);
+         qore_class_private::setNamespace(qc, ns);
+      }
       addInternal(qc);
    }
 }
@@ -143,33 +159,41 @@ int QoreClassList::importSystemClasses(const QoreClassList& source, qore_ns_priv
 }
 
 void QoreClassList::resolveCopy() {
-   for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i)
-      qore_class_private::resolveCopy(*(i->second));
+   for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
+      if (!isShared(i->second))
+         qore_class_private::resolveCopy(*(i->second));
+   }
 }
 
 void QoreClassList::parseInit() {
    for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
       //printd(5, "QoreClassList::parseInit() this: %p initializing %p '%s'\n", this, i->second, i->first);
-      qore_class_private::parseInit(*(i->second));
+      if (!isShared(i->second))
+         qore_class_private::parseInit(*(i->second));
    }
 }
 
 void QoreClassList::parseRollback() {
-   for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i)
-      qore_class_private::parseRollback(*(i->second));
+   for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
+      if (!isShared(i->second))
+         qore_class_private::parseRollback(*(i->second));
+   }
 }
 
 void QoreClassList::parseCommit(QoreClassList& l) {
    assimilate(l);
    for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
       //printd(5, "QoreClassList::parseCommit() this: %p qc: %p '%s' pub: %d\n", this, i->second, i->second->getName(), qore_class_private::isPublic(*i->second));
-      qore_class_private::parseCommit(*(i->second));
+      if (!isShared(i->second))
+         qore_class_private::parseCommit(*(i->second));
    }
 }
 
 void QoreClassList::parseCommitRuntimeInit(ExceptionSink* xsink) {
-   for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i)
-      qore_class_private::parseCommitRuntimeInit(*(i->second), xsink);
+   for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
+      if (!isShared(i->second))
+         qore_class_private::parseCommitRuntimeInit(*(i->second), xsink);
+   }
 }
 
 void QoreClassList::reset() {
@@ -246,34 +270,37 @@ AbstractQoreNode *QoreClassList::findConstant(const char *cname, const QoreTypeI
 
 void QoreClassList::clearConstants(QoreListNode& l) {
    for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
-      qore_class_private::clearConstants(i->second, l);
+      if (!isShared(i->second))
+         qore_class_private::clearConstants(i->second, l);
    }
 }
 
 void QoreClassList::clear(ExceptionSink *xsink) {
    for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
-      qore_class_private::clear(i->second, xsink);
+      if (!isShared(i->second))
+         qore_class_private::clear(i->second, xsink);
    }
 }
 
 void QoreClassList::deleteClassData(ExceptionSink *xsink) {
    for (hm_qc_t::iterator i = hm.begin(), e = hm.end(); i != e; ++i) {
-      qore_class_private::deleteClassData(i->second, xsink);
+      if (!isShared(i->second))
+         qore_class_private::deleteClassData(i->second, xsink);
    }
 }
 
 bool ClassListIterator::isPublic() const {
-   return qore_class_private::isPublic(*i->second);
+   return qore_class_private::isPublic(*i->second) && !ql.isShared(i->second);
 }
 
 bool ConstClassListIterator::isPublic() const {
-   return qore_class_private::isPublic(*i->second);
+   return qore_class_private::isPublic(*i->second) && !ql.isShared(i->second);
 }
 
 bool ClassListIterator::isUserPublic() const {
-   return qore_class_private::isUserPublic(*i->second);
+   return qore_class_private::isUserPublic(*i->second) && !ql.isShared(i->second);
 }
 
 bool ConstClassListIterator::isUserPublic() const {
-   return qore_class_private::isUserPublic(*i->second);
+   return qore_class_private::isUserPublic(*i->second) && !ql.isShared(i->second);
 }
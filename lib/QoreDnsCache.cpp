@@ -0,0 +1,207 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreDnsCache.cpp
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#include <qore/Qore.h>
+#include "qore/intern/QoreDnsCache.h"
+
+#include <string.h>
+
+QoreDnsCache QDC;
+
+// returns true if the lookup failure is definitive and can be cached
+static bool dns_negative_cacheable(int status) {
+   switch (status) {
+      case EAI_NONAME:
+#if defined(EAI_NODATA) && EAI_NODATA != EAI_NONAME
+      case EAI_NODATA:
+#endif
+         return true;
+   }
+   return false;
+}
+
+std::string QoreDnsCache::getKey(const char* node, const char* service, int family, int flags, int socktype, int protocol) {
+   QoreString key;
+   key.sprintf("%d:%d:%d:%d:", family, flags, socktype, protocol);
+   if (node)
+      key.concat(node);
+   // '\0' cannot appear in either string, so it is used as a separator; 1 marks a missing value
+   key.concat('\0');
+   if (service)
+      key.concat(service);
+   else
+      key.concat('\1');
+   return std::string(key.getBuffer(), key.size());
+}
+
+void QoreDnsCache::store(const std::string& key, const dns_entry_t& e, int64 now) {
+   if (dmap.size() >= max) {
+      // remove expired entries first
+      for (dns_map_t::iterator i = dmap.begin(), end = dmap.end(); i != end;) {
+         if (i->second->expires <= now)
+            dmap.erase(i++);
+         else
+            ++i;
+      }
+      // then remove the entry that expires next
+      if (dmap.size() >= max) {
+         dns_map_t::iterator oldest = dmap.begin();
+         for (dns_map_t::iterator i = dmap.begin(), end = dmap.end(); i != end; ++i) {
+            if (i->second->expires < oldest->second->expires)
+               oldest = i;
+         }
+         dmap.erase(oldest);
+      }
+   }
+   dmap[key] = e;
+}
+
+dns_entry_t QoreDnsCache::resolve(const char* node, const char* service, int family, int flags, int socktype, int protocol) {
+   family = q_get_af(family);
+   socktype = q_get_sock_type(socktype);
+
+   struct addrinfo hints;
+   memset(&hints, 0, sizeof hints);
+
+   hints.ai_family = family;
+   hints.ai_flags = flags;
+   hints.ai_socktype = socktype;
+   hints.ai_protocol = protocol;
+
+   // the lookup is made without holding the lock
+   struct addrinfo* ai = nullptr;
+   int status = getaddrinfo(node, service, &hints, &ai);
+   if (status)
+      ai = nullptr;
+
+   int64 now = q_clock_getmillis();
+
+   AutoLocker al(l);
+   int64 t = status ? (dns_negative_cacheable(status) ? negative_ttl : 0) : ttl;
+   dns_entry_t e(new QoreDnsEntry(ai, status, now + t));
+   if (t > 0)
+      store(getKey(node, service, family, flags, socktype, protocol), e, now);
+   return e;
+}
+
+dns_entry_t QoreDnsCache::get(ExceptionSink* xsink, const char* node, const char* service, int family, int flags, int socktype, int protocol) {
+   dns_entry_t e;
+   {
+      std::string key = getKey(node, service, q_get_af(family), flags, q_get_sock_type(socktype), protocol);
+      int64 now = q_clock_getmillis();
+
+      AutoLocker al(l);
+      dns_map_t::iterator i = dmap.find(key);
+      if (i != dmap.end()) {
+         if (i->second->expires > now) {
+            e = i->second;
+            if (e->status)
+               ++negative_hits;
+            else
+               ++hits;
+         }
+         else
+            dmap.erase(i);
+      }
+      if (!e)
+         ++misses;
+   }
+
+   if (!e)
+      e = resolve(node, service, family, flags, socktype, protocol);
+
+   if (e->status) {
+      raiseError(xsink, e->status, node, service, q_get_af(family), flags);
+      return dns_entry_t();
+   }
+   return e;
+}
+
+void QoreDnsCache::raiseError(ExceptionSink* xsink, int status, const char* node, const char* service, int family, int flags) {
+   xsink->raiseException("QOREADDRINFO-GETINFO-ERROR", "getaddrinfo(node: '%s', service: '%s', address_family: %d='%s', flags: %d) error: %s", node ? node : "", service ? service : "", family, QoreAddrInfo::getFamilyName(family), flags, gai_strerror(status));
+}
+
+int QoreDnsCache::setOptions(const QoreHashNode* opts, ExceptionSink* xsink) {
+   int64 n_ttl, n_negative_ttl;
+   size_t n_max;
+   {
+      AutoLocker al(l);
+      n_ttl = ttl;
+      n_negative_ttl = negative_ttl;
+      n_max = max;
+   }
+
+   // accept relative date/time values as well as integers
+   QoreValue n = opts->getValueKeyValue("ttl");
+   if (!n.isNothing())
+      n_ttl = get_ms_zero(n);
+
+   n = opts->getValueKeyValue("negative_ttl");
+   if (!n.isNothing())
+      n_negative_ttl = get_ms_zero(n);
+
+   n = opts->getValueKeyValue("max");
+   if (!n.isNothing()) {
+      int64 v = n.getAsBigInt();
+      if (v <= 0) {
+         xsink->raiseException("DNS-CACHE-ERROR", "the \"max\" option must be greater than zero; got: " QLLD, v);
+         return -1;
+      }
+      n_max = (size_t)v;
+   }
+
+   AutoLocker al(l);
+   ttl = n_ttl;
+   negative_ttl = n_negative_ttl;
+   max = n_max;
+   // entries cached with the old options are discarded
+   dmap.clear();
+   return 0;
+}
+
+QoreHashNode* QoreDnsCache::getInfo() const {
+   QoreHashNode* h = new QoreHashNode;
+
+   AutoLocker al(l);
+   h->setKeyValue("ttl", new QoreBigIntNode(ttl), 0);
+   h->setKeyValue("negative_ttl", new QoreBigIntNode(negative_ttl), 0);
+   h->setKeyValue("max", new QoreBigIntNode(max), 0);
+   h->setKeyValue("size", new QoreBigIntNode(dmap.size()), 0);
+   h->setKeyValue("hits", new QoreBigIntNode(hits), 0);
+   h->setKeyValue("negative_hits", new QoreBigIntNode(negative_hits), 0);
+   h->setKeyValue("misses", new QoreBigIntNode(misses), 0);
+   return h;
+}
+
+void QoreDnsCache::clear() {
+   AutoLocker al(l);
+   dmap.clear();
+}
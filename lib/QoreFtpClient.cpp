@@ -1599,3 +1599,9 @@ void QoreFtpClient::setTimeout(int timeout_ms) {
 int QoreFtpClient::getTimeout() const {
    return priv->timeout_ms;
 }
+
+void QoreFtpClient::setSSLContext(QoreSSLContext* ctx) {
+   AutoLocker al(priv->m);
+   priv->control.priv->setSSLContext(ctx);
+   priv->data.priv->setSSLContext(ctx);
+}
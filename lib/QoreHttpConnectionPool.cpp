@@ -0,0 +1,421 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreHttpConnectionPool.cpp
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+
+#include <qore/Qore.h>
+#include <qore/QoreHttpClientObject.h>
+#include "qore/intern/QoreHttpConnectionPool.h"
+#include "qore/intern/QC_HTTPClient.h"
+#include "qore/intern/QC_SSLContext.h"
+
+// returns the URL with any password masked so that it can be shown in statistics and error messages
+static std::string http_pool_mask_url(const char* url) {
+   std::string str(url);
+   size_t start = str.find("://");
+   start = start == std::string::npos ? 0 : start + 3;
+   size_t at = str.find('@', start);
+   if (at == std::string::npos)
+      return str;
+   size_t slash = str.find('/', start);
+   if (slash != std::string::npos && slash < at)
+      return str;
+   size_t colon = str.find(':', start);
+   if (colon == std::string::npos || colon > at)
+      return str;
+   str.replace(colon + 1, at - colon - 1, "<masked>");
+   return str;
+}
+
+// returns true if the object's connection is open and usable; stale connections (where the server has closed the
+// connection or sent unsolicited data) are closed
+static bool http_pool_check_conn(QoreObject* obj, bool& is_stale) {
+   ExceptionSink xsink;
+   PrivateDataRefHolder<QoreHttpClientObject> client(obj, CID_HTTPCLIENT, &xsink);
+   if (!client) {
+      xsink.clear();
+      return false;
+   }
+   if (!client->isConnected())
+      return false;
+   if (client->isDataAvailable(&xsink, 0)) {
+      client->disconnect();
+      is_stale = true;
+      xsink.clear();
+      return false;
+   }
+   return true;
+}
+
+// closes the connection and returns true if the object is still valid
+static bool http_pool_disconnect(QoreObject* obj) {
+   ExceptionSink xsink;
+   PrivateDataRefHolder<QoreHttpClientObject> client(obj, CID_HTTPCLIENT, &xsink);
+   if (!client) {
+      xsink.clear();
+      return false;
+   }
+   client->disconnect();
+   return true;
+}
+
+QoreHttpConnectionPool::QoreHttpConnectionPool(const QoreHashNode* opts, ExceptionSink* xsink) {
+   if (!opts)
+      return;
+
+   QoreValue n = opts->getValueKeyValue("max");
+   if (!n.isNothing()) {
+      int64 v = n.getAsBigInt();
+      if (v <= 0) {
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the \"max\" option must be greater than zero; got: " QLLD, v);
+         return;
+      }
+      max = max_idle = (unsigned)v;
+   }
+
+   n = opts->getValueKeyValue("max_idle");
+   if (!n.isNothing()) {
+      int64 v = n.getAsBigInt();
+      if (v < 0) {
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the \"max_idle\" option cannot be negative; got: " QLLD, v);
+         return;
+      }
+      max_idle = (unsigned)v;
+   }
+
+   n = opts->getValueKeyValue("min_idle");
+   if (!n.isNothing()) {
+      int64 v = n.getAsBigInt();
+      if (v < 0 || v > max_idle) {
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the \"min_idle\" option must be between 0 and the \"max_idle\" value (%d); got: " QLLD, max_idle, v);
+         return;
+      }
+      min_idle = (unsigned)v;
+   }
+
+   // accept relative date/time values as well as integers
+   n = opts->getValueKeyValue("idle_timeout");
+   if (!n.isNothing())
+      idle_timeout_ms = get_ms_zero(n);
+
+   n = opts->getValueKeyValue("client_opts");
+   if (!n.isNothing()) {
+      if (n.getType() != NT_HASH) {
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the \"client_opts\" option must be a hash; got type \"%s\" instead", n.getTypeName());
+         return;
+      }
+      client_opts = n.get<const QoreHashNode>()->hashRefSelf();
+   }
+
+   n = opts->getValueKeyValue("ssl_context");
+   if (!n.isNothing()) {
+      if (n.getType() != NT_OBJECT) {
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the \"ssl_context\" option must be an SSLContext object; got type \"%s\" instead", n.getTypeName());
+         return;
+      }
+      ssl_ctx = static_cast<QoreSSLContext*>(n.get<const QoreObject>()->getReferencedPrivateData(CID_SSLCONTEXT, xsink));
+      if (!ssl_ctx && !*xsink)
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the \"ssl_context\" option must be an SSLContext object; got class \"%s\" instead", n.get<const QoreObject>()->getClassName());
+   }
+}
+
+QoreHttpConnectionPool::~QoreHttpConnectionPool() {
+   assert(!client_opts);
+   assert(!ssl_ctx);
+   assert(hmap.empty());
+   assert(leased.empty());
+}
+
+void QoreHttpConnectionPool::destructor(ExceptionSink* xsink) {
+   obj_list_t ol;
+   {
+      AutoLocker al(l);
+      valid = false;
+      for (auto& i : hmap) {
+         for (auto& ii : i.second.idle)
+            ol.push_back(ii.obj);
+         if (i.second.waiting)
+            cond.broadcast();
+      }
+      hmap.clear();
+      // leased objects are not closed; they remain valid as long as they are referenced
+      for (auto& i : leased)
+         ol.push_back(i.first);
+      leased.clear();
+   }
+
+   for (auto& i : ol)
+      i->deref(xsink);
+
+   if (client_opts) {
+      client_opts->deref(xsink);
+      client_opts = nullptr;
+   }
+   if (ssl_ctx) {
+      ssl_ctx->deref(xsink);
+      ssl_ctx = nullptr;
+   }
+}
+
+QoreObject* QoreHttpConnectionPool::create(const std::string& target, ExceptionSink* xsink) {
+   ReferenceHolder<QoreHttpClientObject> client(new QoreHttpClientObject, xsink);
+   if (client_opts && client->setOptions(client_opts, xsink))
+      return nullptr;
+   if (client->setURL(target.c_str(), xsink))
+      return nullptr;
+   if (ssl_ctx)
+      client->setSSLContext(ssl_ctx);
+
+   return new QoreObject(QC_HTTPCLIENT, getProgram(), client.release());
+}
+
+void QoreHttpConnectionPool::expire(host_pool_t& hp, int64 now_us, obj_list_t& ol) {
+   if (!idle_timeout_ms)
+      return;
+   int64 cutoff = now_us - idle_timeout_ms * 1000;
+   // the least recently used connections are at the back of the list
+   while (hp.idle.size() > min_idle && hp.idle.back().time_us <= cutoff) {
+      ol.push_back(hp.idle.back().obj);
+      hp.idle.pop_back();
+      ++closed;
+   }
+}
+
+void QoreHttpConnectionPool::close(obj_list_t& ol, ExceptionSink* xsink) {
+   for (auto& i : ol) {
+      http_pool_disconnect(i);
+      i->deref(xsink);
+   }
+   ol.clear();
+}
+
+QoreObject* QoreHttpConnectionPool::get(const QoreString& url, int timeout_ms, std::string& path, ExceptionSink* xsink) {
+   QoreURL qurl(&url, true, xsink);
+   if (*xsink)
+      return nullptr;
+   if (!qurl.isValid() || !qurl.getHost()) {
+      xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "cannot determine the target host from URL '%s'", http_pool_mask_url(url.c_str()).c_str());
+      return nullptr;
+   }
+
+   // build the target string for the pool
+   std::string target = qurl.getProtocol() ? qurl.getProtocol()->c_str() : "http";
+   target += "://";
+   if (qurl.getUserName()) {
+      target += qurl.getUserName()->c_str();
+      if (qurl.getPassword()) {
+         target += ':';
+         target += qurl.getPassword()->c_str();
+      }
+      target += '@';
+   }
+   target += qurl.getHost()->c_str();
+   if (qurl.getPort()) {
+      target += ':';
+      target += std::to_string(qurl.getPort());
+   }
+
+   if (qurl.getPath())
+      path = qurl.getPath()->c_str();
+   else
+      path.clear();
+
+   obj_list_t ol;
+   QoreObject* rv = getIntern(target, http_pool_mask_url(target.c_str()), timeout_ms, ol, xsink);
+   close(ol, xsink);
+   return rv;
+}
+
+QoreObject* QoreHttpConnectionPool::getIntern(const std::string& target, const std::string& desc, int timeout_ms, obj_list_t& ol, ExceptionSink* xsink) {
+   QoreObject* rv = nullptr;
+   {
+      SafeLocker sl(l);
+      while (true) {
+         if (!valid) {
+            xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the HTTPConnectionPool object was deleted while TID %d was waiting on a connection to '%s'", gettid(), desc.c_str());
+            return nullptr;
+         }
+
+         host_pool_t& hp = hmap[target];
+         if (hp.desc.empty())
+            hp.desc = desc;
+         expire(hp, q_clock_getmicros(), ol);
+
+         if (!hp.idle.empty()) {
+            rv = hp.idle.front().obj;
+            hp.idle.pop_front();
+            ++hp.in_use;
+            leased[rv] = target;
+            break;
+         }
+
+         if (hp.in_use < max) {
+            // reserve the connection slot
+            ++hp.in_use;
+            break;
+         }
+
+         ++hp.waiting;
+         ++waits;
+         int rc = timeout_ms > 0 ? cond.wait2(l, timeout_ms) : cond.wait(l);
+         --hp.waiting;
+
+         if (rc && timeout_ms > 0 && valid) {
+            ++timeouts;
+            xsink->raiseException("HTTPCONNECTIONPOOL-TIMEOUT", "TID %d timed out after waiting %d millisecond%s for a connection to '%s' (max %d connections in use)", gettid(), timeout_ms, timeout_ms == 1 ? "" : "s", desc.c_str(), max);
+            return nullptr;
+         }
+      }
+   }
+
+   if (rv) {
+      // health check: make sure that the server has not closed the idle connection; stale connections are closed
+      // and HTTPClient will reconnect automatically on the next request
+      bool is_stale = false;
+      bool ok = http_pool_check_conn(rv, is_stale);
+      AutoLocker al(l);
+      if (ok)
+         ++reused;
+      else if (is_stale)
+         ++stale;
+   }
+   else {
+      rv = create(target, xsink);
+      AutoLocker al(l);
+      if (!rv) {
+         host_map_t::iterator i = hmap.find(target);
+         if (i != hmap.end()) {
+            --i->second.in_use;
+            if (i->second.waiting)
+               cond.broadcast();
+         }
+         return nullptr;
+      }
+      if (!valid) {
+         ol.push_back(rv);
+         xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the HTTPConnectionPool object was deleted while TID %d was acquiring a connection to '%s'", gettid(), desc.c_str());
+         return nullptr;
+      }
+      leased[rv] = target;
+      ++created;
+   }
+
+   // the pool keeps its own reference to leased objects
+   rv->ref();
+   return rv;
+}
+
+int QoreHttpConnectionPool::release(QoreObject* obj, bool discard, ExceptionSink* xsink) {
+   bool is_stale = false;
+   bool ok = !discard && http_pool_check_conn(obj, is_stale);
+
+   SafeLocker sl(l);
+   leased_map_t::iterator i = leased.find(obj);
+   if (i == leased.end()) {
+      sl.unlock();
+      xsink->raiseException("HTTPCONNECTIONPOOL-ERROR", "the HTTPClient object passed to HTTPConnectionPool::release() is not leased from this pool");
+      return -1;
+   }
+
+   host_map_t::iterator hi = hmap.find(i->second);
+   assert(hi != hmap.end());
+   leased.erase(i);
+   host_pool_t& hp = hi->second;
+   --hp.in_use;
+
+   if (is_stale)
+      ++stale;
+
+   bool keep = ok && valid && hp.idle.size() < max_idle;
+   if (keep)
+      hp.idle.push_front({obj, q_clock_getmicros()});
+   else
+      ++closed;
+
+   if (hp.waiting)
+      cond.broadcast();
+   sl.unlock();
+
+   if (!keep) {
+      obj_list_t ol = {obj};
+      close(ol, xsink);
+   }
+   return 0;
+}
+
+void QoreHttpConnectionPool::clear(ExceptionSink* xsink) {
+   obj_list_t ol;
+   {
+      AutoLocker al(l);
+      for (auto& i : hmap) {
+         for (auto& ii : i.second.idle) {
+            ol.push_back(ii.obj);
+            ++closed;
+         }
+         i.second.idle.clear();
+      }
+   }
+   close(ol, xsink);
+}
+
+QoreHashNode* QoreHttpConnectionPool::getStats() const {
+   QoreHashNode* h = new QoreHashNode;
+   QoreHashNode* th = new QoreHashNode;
+
+   AutoLocker al(l);
+   h->setKeyValue("max", new QoreBigIntNode(max), nullptr);
+   h->setKeyValue("max_idle", new QoreBigIntNode(max_idle), nullptr);
+   h->setKeyValue("min_idle", new QoreBigIntNode(min_idle), nullptr);
+   h->setKeyValue("idle_timeout", new QoreBigIntNode(idle_timeout_ms), nullptr);
+   h->setKeyValue("created", new QoreBigIntNode(created), nullptr);
+   h->setKeyValue("reused", new QoreBigIntNode(reused), nullptr);
+   h->setKeyValue("closed", new QoreBigIntNode(closed), nullptr);
+   h->setKeyValue("stale", new QoreBigIntNode(stale), nullptr);
+   h->setKeyValue("waits", new QoreBigIntNode(waits), nullptr);
+   h->setKeyValue("timeouts", new QoreBigIntNode(timeouts), nullptr);
+
+   // targets are reported with any password masked; targets that differ only by password are reported together
+   std::map<std::string, host_pool_t> dmap;
+   for (auto& i : hmap) {
+      host_pool_t& dp = dmap[i.second.desc];
+      dp.in_use += i.second.in_use;
+      dp.waiting += i.second.waiting;
+      dp.idle.insert(dp.idle.end(), i.second.idle.begin(), i.second.idle.end());
+   }
+   for (auto& i : dmap) {
+      QoreHashNode* hph = new QoreHashNode;
+      hph->setKeyValue("idle", new QoreBigIntNode(i.second.idle.size()), nullptr);
+      hph->setKeyValue("in_use", new QoreBigIntNode(i.second.in_use), nullptr);
+      hph->setKeyValue("waiting", new QoreBigIntNode(i.second.waiting), nullptr);
+      th->setKeyValue(i.first.c_str(), hph, nullptr);
+   }
+   h->setKeyValue("targets", th, nullptr);
+   return h;
+}
@@ -33,6 +33,9 @@
 QoreString QoreMinusOperatorNode::minus_str("- operator expression");
 
 QoreValue QoreMinusOperatorNode::evalValueImpl(bool& needs_deref, ExceptionSink* xsink) const {
+   if (pfunc)
+      return (this->*pfunc)(xsink);
+
    ValueEvalRefHolder lh(left, xsink);
    if (*xsink)
       return QoreValue();
@@ -135,5 +138,36 @@ AbstractQoreNode* QoreMinusOperatorNode::parseInitImpl(LocalVar* oflag, int pfla
    if (returnTypeInfo)
       parseTypeInfo = returnTypeInfo;
 
+   // use optimized versions if PO_OPTIMIZE_ARITHMETIC is set and both arguments are known to be ints or floats at parse time
+   if (parse_check_parse_option(PO_OPTIMIZE_ARITHMETIC)) {
+      if (QoreTypeInfo::isType(leftTypeInfo, NT_INT) && QoreTypeInfo::isType(rightTypeInfo, NT_INT))
+         pfunc = &QoreMinusOperatorNode::bigIntMinus;
+      else if ((QoreTypeInfo::isType(leftTypeInfo, NT_FLOAT) || QoreTypeInfo::isType(leftTypeInfo, NT_INT))
+         && (QoreTypeInfo::isType(rightTypeInfo, NT_FLOAT) || QoreTypeInfo::isType(rightTypeInfo, NT_INT)))
+         pfunc = &QoreMinusOperatorNode::floatMinus;
+   }
+
    return this;
 }
+
+QoreValue QoreMinusOperatorNode::floatMinus(ExceptionSink* xsink) const {
+   double l = left->floatEval(xsink);
+   if (*xsink)
+      return QoreValue();
+   double r = right->floatEval(xsink);
+   if (*xsink)
+      return QoreValue();
+
+   return l - r;
+}
+
+QoreValue QoreMinusOperatorNode::bigIntMinus(ExceptionSink* xsink) const {
+   int64 l = left->bigIntEval(xsink);
+   if (*xsink)
+      return QoreValue();
+   int64 r = right->bigIntEval(xsink);
+   if (*xsink)
+      return QoreValue();
+
+   return l - r;
+}
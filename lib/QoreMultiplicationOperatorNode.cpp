@@ -33,6 +33,9 @@
 QoreString QoreMultiplicationOperatorNode::multiplication_str("* operator expression");
 
 QoreValue QoreMultiplicationOperatorNode::evalValueImpl(bool& needs_deref, ExceptionSink* xsink) const {
+   if (pfunc)
+      return (this->*pfunc)(xsink);
+
    ValueEvalRefHolder lh(left, xsink);
    if (*xsink)
       return QoreValue();
@@ -89,5 +92,36 @@ AbstractQoreNode* QoreMultiplicationOperatorNode::parseInitImpl(LocalVar* oflag,
          returnTypeInfo = bigIntTypeInfo;
    }
 
+   // use optimized versions if PO_OPTIMIZE_ARITHMETIC is set and both arguments are known to be ints or floats at parse time
+   if (parse_check_parse_option(PO_OPTIMIZE_ARITHMETIC)) {
+      if (QoreTypeInfo::isType(leftTypeInfo, NT_INT) && QoreTypeInfo::isType(rightTypeInfo, NT_INT))
+         pfunc = &QoreMultiplicationOperatorNode::bigIntMultiply;
+      else if ((QoreTypeInfo::isType(leftTypeInfo, NT_FLOAT) || QoreTypeInfo::isType(leftTypeInfo, NT_INT))
+         && (QoreTypeInfo::isType(rightTypeInfo, NT_FLOAT) || QoreTypeInfo::isType(rightTypeInfo, NT_INT)))
+         pfunc = &QoreMultiplicationOperatorNode::floatMultiply;
+   }
+
    return this;
 }
+
+QoreValue QoreMultiplicationOperatorNode::floatMultiply(ExceptionSink* xsink) const {
+   double l = left->floatEval(xsink);
+   if (*xsink)
+      return QoreValue();
+   double r = right->floatEval(xsink);
+   if (*xsink)
+      return QoreValue();
+
+   return l * r;
+}
+
+QoreValue QoreMultiplicationOperatorNode::bigIntMultiply(ExceptionSink* xsink) const {
+   int64 l = left->bigIntEval(xsink);
+   if (*xsink)
+      return QoreValue();
+   int64 r = right->bigIntEval(xsink);
+   if (*xsink)
+      return QoreValue();
+
+   return l * r;
+}
@@ -46,15 +46,21 @@
 #include "qore/intern/QC_Socket.h"
 #include "qore/intern/QC_SSLCertificate.h"
 #include "qore/intern/QC_SSLPrivateKey.h"
+#include "qore/intern/QC_SSLContext.h"
 #include "qore/intern/QC_Program.h"
 #include "qore/intern/QC_File.h"
 #include "qore/intern/QC_Dir.h"
 #include "qore/intern/QC_GetOpt.h"
 #include "qore/intern/QC_FtpClient.h"
 #include "qore/intern/QC_HTTPClient.h"
+#include "qore/intern/QC_HTTPConnectionPool.h"
+#include "qore/intern/QC_SocketPollSet.h"
 #include "qore/intern/QC_TermIOS.h"
 #include "qore/intern/QC_TimeZone.h"
 #include "qore/intern/QC_TreeMap.h"
+#include "qore/intern/CsvRecordBuilder.h"
+#include "qore/intern/QC_DateFormat.h"
+#include "qore/intern/QC_StringBuilder.h"
 
 #include "qore/intern/QC_Datasource.h"
 #include "qore/intern/QC_DatasourcePool.h"
@@ -920,6 +926,7 @@ StaticSystemNamespace::StaticSystemNamespace() : RootQoreNamespace(new qore_root
    qns.addSystemClass(initTimeZoneClass(qns));
    qns.addSystemClass(initSSLCertificateClass(qns));
    qns.addSystemClass(initSSLPrivateKeyClass(qns));
+   qns.addSystemClass(initSSLContextClass(qns));
    qns.addSystemClass(initSocketClass(qns));
    qns.addSystemClass(initProgramClass(qns));
 
@@ -932,6 +939,8 @@ StaticSystemNamespace::StaticSystemNamespace() : RootQoreNamespace(new qore_root
 
    // add HTTPClient namespace
    qns.addSystemClass(initHTTPClientClass(qns));
+   qns.addSystemClass(initHTTPConnectionPoolClass(qns));
+   qns.addSystemClass(initSocketPollSetClass(qns));
 
    qns.addSystemClass(initAbstractIteratorClass(qns));
    qns.addSystemClass(initAbstractQuantifiedIteratorClass(qns));
@@ -962,6 +971,9 @@ StaticSystemNamespace::StaticSystemNamespace() : RootQoreNamespace(new qore_root
    qns.addSystemClass(initSingleValueIteratorClass(qns));
    qns.addSystemClass(initRangeIteratorClass(qns));
    qns.addSystemClass(initTreeMapClass(qns));
+   qns.addSystemClass(initCsvRecordBuilderClass(qns));
+   qns.addSystemClass(initDateFormatClass(qns));
+   qns.addSystemClass(initStringBuilderClass(qns));
 
 #ifdef DEBUG_TESTS
    { // tests
@@ -1061,6 +1073,12 @@ int qore_root_ns_private::parseAddMethodToClassIntern(const QoreProgramLocation&
    if (!oc)
       return -1;
 
+   // classes shared from user modules are referenced by all importing Programs and cannot be modified
+   if (qore_class_private::get(*oc)->shared) {
+      parseException(loc, "ILLEGAL-METHOD-DEFINITION", "cannot add method '%s()' to class '%s' because the class is shared from the user module that defines it (conflicts with parse option SHARE_MODULE_CLASSES)", scname.getIdentifier(), oc->getName());
+      return -1;
+   }
+
    return qore_class_private::addUserMethod(*oc, scname.getIdentifier(), v.release(), static_flag);
 }
 
@@ -2152,14 +2170,14 @@ void qore_ns_private::scanMergeCommittedNamespace(const qore_ns_private& mns, Qo
    }
 }
 
-void qore_ns_private::copyMergeCommittedNamespace(const qore_ns_private& mns) {
+void qore_ns_private::copyMergeCommittedNamespace(const qore_ns_private& mns, bool share) {
    //printd(5, "qore_ns_private::copyMergeCommittedNamespace() this: %p '%s'\n", this, name.c_str());
 
    // merge in source constants
    constant.mergeUserPublic(mns.constant);
 
    // merge in source classes
-   classList.mergeUserPublic(mns.classList, this);
+   classList.mergeUserPublic(mns.classList, this, share);
 
    // merge in source hashdecls
    hashDeclList.mergeUserPublic(mns.hashDeclList);
@@ -2187,7 +2205,7 @@ void qore_ns_private::copyMergeCommittedNamespace(const qore_ns_private& mns) {
          nsl.runtimeAdd(nns, this);
       }
 
-      nns->priv->copyMergeCommittedNamespace(*i->second->priv);
+      nns->priv->copyMergeCommittedNamespace(*i->second->priv, share);
       //printd(5, "qore_ns_private::copyMergeCommittedNamespace() this: %p '%s::' merged %p '%s::'\n", this, name.c_str(), ns, ns->getName());
    }
    //printd(5, "qore_ns_private::copyMergeCommittedNamespace() this: %p '%s' done\n", this, name.c_str());
@@ -31,6 +31,7 @@
 */
 
 #include <qore/Qore.h>
+#include "qore/intern/QoreDnsCache.h"
 
 #include <strings.h>
 #include <string.h>
@@ -408,11 +409,11 @@ QoreStringNode* q_gethostbyaddr_to_string(ExceptionSink* xsink, const char* addr
 }
 
 QoreListNode* q_getaddrinfo_to_list(ExceptionSink* xsink, const char* node, const char* service, int family, int flags, int socktype) {
-   QoreAddrInfo ai;
-   if (ai.getInfo(xsink, node, service, family, flags, socktype))
+   dns_entry_t e = QDC.get(xsink, node, service, family, flags, socktype);
+   if (!e)
       return 0;
 
-   return ai.getList();
+   return q_addrinfo_to_list(e->ai, (bool)service);
 }
 
 QoreAddrInfo::QoreAddrInfo() : ai(0), has_svc(false) {
@@ -448,7 +449,7 @@ int QoreAddrInfo::getInfo(ExceptionSink* xsink, const char* node, const char* se
    int status = getaddrinfo(node, service, &hints, &ai);
    if (status) {
       if (xsink)
-         xsink->raiseException("QOREADDRINFO-GETINFO-ERROR", "getaddrinfo(node: '%s', service: '%s', address_family: %d='%s', flags: %d) error: %s", node ? node : "", service ? service : "", family, q_af_to_str(family), flags, gai_strerror(status));
+         QoreDnsCache::raiseError(xsink, status, node, service, family, flags);
       return -1;
    }
 
@@ -461,9 +462,13 @@ QoreListNode* QoreAddrInfo::getList() const {
    if (!ai)
       return 0;
 
+   return q_addrinfo_to_list(ai, has_svc);
+}
+
+QoreListNode* q_addrinfo_to_list(const struct addrinfo* ai, bool has_svc) {
    QoreListNode* l = new QoreListNode;
 
-   for (struct addrinfo* p = ai; p; p = p->ai_next) {
+   for (const struct addrinfo* p = ai; p; p = p->ai_next) {
       QoreHashNode* h = new QoreHashNode;
 
       const char* family = q_af_to_str(p->ai_family);
@@ -474,7 +479,7 @@ QoreListNode* QoreAddrInfo::getList() const {
       QoreStringNode* addr = q_addr_to_string2(p->ai_addr);
       if (addr) {
          h->setKeyValue("address", addr, 0);
-         h->setKeyValue("address_desc", getAddressDesc(p->ai_family, addr->getBuffer()), 0);
+         h->setKeyValue("address_desc", QoreAddrInfo::getAddressDesc(p->ai_family, addr->getBuffer()), 0);
       }
 
       h->setKeyValue("family", new QoreBigIntNode(p->ai_family), 0);
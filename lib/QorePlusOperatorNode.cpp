@@ -35,6 +35,9 @@
 QoreString QorePlusOperatorNode::plus_str("+ operator expression");
 
 QoreValue QorePlusOperatorNode::evalValueImpl(bool& needs_deref, ExceptionSink* xsink) const {
+   if (pfunc)
+      return (this->*pfunc)(xsink);
+
    ValueEvalRefHolder lh(left, xsink);
    if (*xsink)
       return QoreValue();
@@ -217,5 +220,36 @@ AbstractQoreNode* QorePlusOperatorNode::parseInitImpl(LocalVar* oflag, int pflag
    if (returnTypeInfo)
       parseTypeInfo = returnTypeInfo;
 
+   // use optimized versions if PO_OPTIMIZE_ARITHMETIC is set and both arguments are known to be ints or floats at parse time
+   if (parse_check_parse_option(PO_OPTIMIZE_ARITHMETIC)) {
+      if (QoreTypeInfo::isType(leftTypeInfo, NT_INT) && QoreTypeInfo::isType(rightTypeInfo, NT_INT))
+         pfunc = &QorePlusOperatorNode::bigIntPlus;
+      else if ((QoreTypeInfo::isType(leftTypeInfo, NT_FLOAT) || QoreTypeInfo::isType(leftTypeInfo, NT_INT))
+         && (QoreTypeInfo::isType(rightTypeInfo, NT_FLOAT) || QoreTypeInfo::isType(rightTypeInfo, NT_INT)))
+         pfunc = &QorePlusOperatorNode::floatPlus;
+   }
+
    return this;
 }
+
+QoreValue QorePlusOperatorNode::floatPlus(ExceptionSink* xsink) const {
+   double l = left->floatEval(xsink);
+   if (*xsink)
+      return QoreValue();
+   double r = right->floatEval(xsink);
+   if (*xsink)
+      return QoreValue();
+
+   return l + r;
+}
+
+QoreValue QorePlusOperatorNode::bigIntPlus(ExceptionSink* xsink) const {
+   int64 l = left->bigIntEval(xsink);
+   if (*xsink)
+      return QoreValue();
+   int64 r = right->bigIntEval(xsink);
+   if (*xsink)
+      return QoreValue();
+
+   return l + r;
+}
@@ -132,6 +132,8 @@ ParseOptionMaps::ParseOptionMaps() {
       doMap(PO_BROKEN_LOGIC_PRECEDENCE, "PO_BROKEN_LOGIC_PRECEDENCE");
       doMap(PO_BROKEN_LOOP_STATEMENT, "PO_BROKEN_LOOP_STATEMENT");
       doMap(PO_BROKEN_REFERENCES, "PO_BROKEN_REFERENCES");
+      doMap(PO_OPTIMIZE_ARITHMETIC, "PO_OPTIMIZE_ARITHMETIC");
+      doMap(PO_SHARE_MODULE_CLASSES, "PO_SHARE_MODULE_CLASSES");
 }
 
 QoreHashNode* ParseOptionMaps::getCodeToStringMap() const {
@@ -343,10 +345,12 @@ void qore_program_private::waitForTerminationAndClear(ExceptionSink* xsink) {
          // wait for all threads to terminate
          waitForAllThreadsToTerminateIntern();
          if (!ptid) {
-            l = new QoreListNode;
-            qore_root_ns_private::clearConstants(*RootNS, **l);
             // mark the program so that only code from this thread can run during data destruction
             ptid = gettid();
+            // threads enter the Program without plock, so wait for any thread that entered before ptid was set
+            waitForAllThreadsToTerminateIntern();
+            l = new QoreListNode;
+            qore_root_ns_private::clearConstants(*RootNS, **l);
             clr = true;
          }
       }
@@ -0,0 +1,152 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreSSLContext.cpp
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+
+#include <qore/Qore.h>
+#include "qore/intern/QoreSSLContext.h"
+
+#include <openssl/err.h>
+
+#include <limits.h>
+
+static void ssl_context_error(ExceptionSink* xsink, const char* func) {
+   long e = ERR_get_error();
+   char buf[121];
+   ERR_error_string(e, buf);
+   xsink->raiseException("SSLCONTEXT-ERROR", "%s() failed: %s", func, buf);
+}
+
+// called by OpenSSL when a new session has been negotiated; client sessions are stored in the context's client
+// session cache, server sessions are only stored in the OpenSSL internal session cache
+static int q_ssl_new_session(SSL* ssl, SSL_SESSION* sess) {
+   const std::string* peer = (const std::string*)SSL_get_app_data(ssl);
+   if (!peer)
+      return 0;
+
+   QoreSSLContext* qctx = (QoreSSLContext*)SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+   qctx->addClientSession(*peer, sess);
+   // we have taken over the reference to the session
+   return 1;
+}
+
+QoreSSLContext::QoreSSLContext(X509* cert, EVP_PKEY* pk, int cache_size, ExceptionSink* xsink) : max_client(cache_size) {
+   ctx = SSL_CTX_new(SSLv23_method());
+   if (!ctx) {
+      ssl_context_error(xsink, "SSL_CTX_new");
+      return;
+   }
+   if (cert && !SSL_CTX_use_certificate(ctx, cert)) {
+      ssl_context_error(xsink, "SSL_CTX_use_certificate");
+      return;
+   }
+   if (pk && !SSL_CTX_use_PrivateKey(ctx, pk)) {
+      ssl_context_error(xsink, "SSL_CTX_use_PrivateKey");
+      return;
+   }
+
+   SSL_CTX_set_app_data(ctx, this);
+   if (!cache_size) {
+      SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+      SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+      return;
+   }
+
+   SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH);
+   SSL_CTX_sess_set_cache_size(ctx, cache_size);
+   SSL_CTX_sess_set_new_cb(ctx, q_ssl_new_session);
+   // a session ID context is required for server-side session resumption when peer certificates are verified
+   SSL_CTX_set_session_id_context(ctx, (const unsigned char*)"qore", 4);
+}
+
+QoreSSLContext::~QoreSSLContext() {
+   clearClientSessions();
+   if (ctx)
+      SSL_CTX_free(ctx);
+}
+
+void QoreSSLContext::setClientSession(SSL* ssl, const std::string& peer) {
+   AutoLocker al(l);
+   session_map_t::iterator i = cmap.find(peer);
+   if (i != cmap.end())
+      SSL_set_session(ssl, i->second);
+}
+
+void QoreSSLContext::addClientSession(const std::string& peer, SSL_SESSION* sess) {
+   AutoLocker al(l);
+   session_map_t::iterator i = cmap.lower_bound(peer);
+   if (i != cmap.end() && i->first == peer) {
+      SSL_SESSION_free(i->second);
+      i->second = sess;
+      return;
+   }
+
+   if (cmap.size() >= max_client) {
+      if (!max_client) {
+         SSL_SESSION_free(sess);
+         return;
+      }
+      // make room for the new session
+      session_map_t::iterator ri = cmap.begin();
+      if (ri == i)
+         ++i;
+      SSL_SESSION_free(ri->second);
+      cmap.erase(ri);
+   }
+
+   cmap.insert(i, session_map_t::value_type(peer, sess));
+}
+
+void QoreSSLContext::clearSessions() {
+   AutoLocker al(l);
+   clearClientSessions();
+   // remove all sessions from the internal session cache
+   SSL_CTX_flush_sessions(ctx, LONG_MAX);
+}
+
+void QoreSSLContext::clearClientSessions() {
+   for (auto& i : cmap)
+      SSL_SESSION_free(i.second);
+   cmap.clear();
+}
+
+QoreHashNode* QoreSSLContext::getStats() const {
+   QoreHashNode* h = new QoreHashNode;
+
+   AutoLocker al(l);
+   h->setKeyValue("client_sessions", new QoreBigIntNode(cmap.size()), 0);
+   h->setKeyValue("cached_sessions", new QoreBigIntNode(SSL_CTX_sess_number(ctx)), 0);
+   h->setKeyValue("hits", new QoreBigIntNode(SSL_CTX_sess_hits(ctx)), 0);
+   h->setKeyValue("misses", new QoreBigIntNode(SSL_CTX_sess_misses(ctx)), 0);
+   h->setKeyValue("timeouts", new QoreBigIntNode(SSL_CTX_sess_timeouts(ctx)), 0);
+   h->setKeyValue("accept_good", new QoreBigIntNode(SSL_CTX_sess_accept_good(ctx)), 0);
+   h->setKeyValue("connect_good", new QoreBigIntNode(SSL_CTX_sess_connect_good(ctx)), 0);
+   return h;
+}
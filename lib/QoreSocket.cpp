@@ -37,6 +37,21 @@
 #include <qore/QoreSocket.h>
 
 #include "qore/intern/qore_socket_private.h"
+#include "qore/intern/FileInputStream.h"
+#include "qore/intern/QoreWebSocket.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef QORE_USE_WRITEV
+#include <sys/uio.h>
+#endif
+
+#ifdef QORE_USE_SENDFILE
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#endif
 
 void se_in_op(const char* cname, const char* meth, ExceptionSink* xsink) {
    assert(xsink);
@@ -291,37 +306,69 @@ void SSLSocketHelperHelper::error() {
       s->ssl = nullptr;
 }
 
+SSLSocketHelper::~SSLSocketHelper() {
+   if (ssl)
+      SSL_free(ssl);
+   if (ctx)
+      SSL_CTX_free(ctx);
+   if (sctx)
+      sctx->deref();
+}
+
 int SSLSocketHelper::setIntern(const char* mname, int sd, X509* cert, EVP_PKEY* pk, ExceptionSink* xsink) {
    SSLSocketReferenceHelper ssrh(this);
 
    assert(!ssl);
    assert(!ctx);
-   ctx = SSL_CTX_new(meth);
-   if (!ctx) {
-      sslError(xsink, mname, "SSL_CTX_new");
-      assert(*xsink);
-      return -1;
-   }
-   if (cert) {
-      if (!SSL_CTX_use_certificate(ctx, cert)) {
-	 sslError(xsink, mname, "SSL_CTX_use_certificate");
-	 assert(*xsink);
-	 return -1;
+   if (qs.ssl_ctx) {
+      // use the shared context; any certificate and private key given here override those of the context
+      sctx = qs.ssl_ctx;
+      sctx->ref();
+      ssl = SSL_new(sctx->getContext());
+      if (!ssl) {
+         sslError(xsink, mname, "SSL_new");
+         assert(*xsink);
+         return -1;
       }
-   }
-   if (pk) {
-      if (!SSL_CTX_use_PrivateKey(ctx, pk)) {
-	 sslError(xsink, mname, "SSL_CTX_use_PrivateKey");
-	 assert(*xsink);
-	 return -1;
+      if (cert && !SSL_use_certificate(ssl, cert)) {
+         sslError(xsink, mname, "SSL_use_certificate");
+         assert(*xsink);
+         return -1;
+      }
+      if (pk && !SSL_use_PrivateKey(ssl, pk)) {
+         sslError(xsink, mname, "SSL_use_PrivateKey");
+         assert(*xsink);
+         return -1;
       }
    }
+   else {
+      ctx = SSL_CTX_new(meth);
+      if (!ctx) {
+         sslError(xsink, mname, "SSL_CTX_new");
+         assert(*xsink);
+         return -1;
+      }
+      if (cert) {
+         if (!SSL_CTX_use_certificate(ctx, cert)) {
+            sslError(xsink, mname, "SSL_CTX_use_certificate");
+            assert(*xsink);
+            return -1;
+         }
+      }
+      if (pk) {
+         if (!SSL_CTX_use_PrivateKey(ctx, pk)) {
+            sslError(xsink, mname, "SSL_CTX_use_PrivateKey");
+            assert(*xsink);
+            return -1;
+         }
+      }
 
-   ssl = SSL_new(ctx);
-   if (!ssl) {
-      sslError(xsink, mname, "SSL_new");
-      assert(*xsink);
-      return -1;
+      ssl = SSL_new(ctx);
+      if (!ssl) {
+         sslError(xsink, mname, "SSL_new");
+         assert(*xsink);
+         return -1;
+      }
    }
 
    // turn on SSL_MODE_ENABLE_PARTIAL_WRITE
@@ -339,9 +386,45 @@ int SSLSocketHelper::setIntern(const char* mname, int sd, X509* cert, EVP_PKEY*
    return 0;
 }
 
+// gets a key for client session caching from the peer address; returns 0 for OK, -1 for error
+static int q_get_peer_key(int sd, std::string& key) {
+   struct sockaddr_storage addr;
+   socklen_t len = sizeof addr;
+   if (getpeername(sd, (struct sockaddr*)&addr, &len))
+      return -1;
+
+   if (addr.ss_family == AF_INET || addr.ss_family == AF_INET6) {
+      char ifname[INET6_ADDRSTRLEN];
+      if (!inet_ntop(addr.ss_family, qore_socket_private::get_in_addr((struct sockaddr*)&addr), ifname, sizeof(ifname)))
+         return -1;
+      key = ifname;
+      key += ':';
+      key += std::to_string(q_get_port_from_addr((const struct sockaddr*)&addr));
+      return 0;
+   }
+#ifndef _Q_WINDOWS
+   if (addr.ss_family == AF_UNIX) {
+      key = ((struct sockaddr_un*)&addr)->sun_path;
+      return 0;
+   }
+#endif
+   return -1;
+}
+
 int SSLSocketHelper::setClient(const char* mname, int sd, X509* cert, EVP_PKEY* pk, ExceptionSink* xsink) {
    meth = SSLv23_client_method();
-   return setIntern(mname, sd, cert, pk, xsink);
+   if (setIntern(mname, sd, cert, pk, xsink))
+      return -1;
+
+   // try to resume the last session with the same server; the host name used to connect is part of the key so
+   // that a session negotiated with one virtual host is never offered to another one at the same address
+   if (sctx && !q_get_peer_key(sd, peer)) {
+      peer.insert(0, "/");
+      peer.insert(0, qs.peer_host);
+      SSL_set_app_data(ssl, &peer);
+      sctx->setClientSession(ssl, peer);
+   }
+   return 0;
 }
 
 int SSLSocketHelper::setServer(const char* mname, int sd, X509* cert, EVP_PKEY* pk, ExceptionSink* xsink) {
@@ -470,6 +553,14 @@ long SSLSocketHelper::verifyPeerCertificate() const {
    return rc;
 }
 
+bool SSLSocketHelper::sessionReused() const {
+   return SSL_session_reused(ssl);
+}
+
+int SSLSocketHelper::pending() const {
+   return SSL_pending(ssl);
+}
+
 static int q_ssl_verify_accept_all(int preverify_ok, X509_STORE_CTX* x509_ctx) {
    //printd(5, " q_ssl_verify_accept_all() preverify_ok: %d x509_ctx: %p\n", preverify_ok, x509_ctx);
    // accept all certificates
@@ -528,6 +619,32 @@ int qore_socket_private::send(int fd, qore_offset_t size, int timeout_ms, Except
       return -1;
    }
 
+#ifdef QORE_USE_SENDFILE
+   // send regular files without copying the data through user space if possible
+   if (!ssl) {
+      if (in_op >= 0) {
+         if (in_op == gettid())
+            se_in_op("Socket", "send", xsink);
+         else
+            se_in_op_thread("Socket", "send", xsink);
+         return -1;
+      }
+
+      PrivateQoreSocketThroughputHelper th(this, true);
+      OptionalNonBlockingHelper onbh(*this, timeout_ms >= 0, xsink);
+      if (*xsink)
+         return -1;
+
+      int64 total = 0;
+      int rc = sendFileIntern(xsink, "Socket", "send", fd, size, timeout_ms, total);
+      if (rc <= 0) {
+         if (!rc)
+            th.finalize(total);
+         return rc;
+      }
+   }
+#endif
+
    char* buf = (char*)malloc(sizeof(char) * DEFAULT_SOCKET_BUFSIZE);
    ON_BLOCK_EXIT(free, buf);
 
@@ -558,6 +675,9 @@ int qore_socket_private::send(int fd, qore_offset_t size, int timeout_ms, Except
          //printd(5, "QoreSocket::send() read error: %s\n", strerror(errno));
          break;
       }
+      // end of file
+      if (!rc)
+         break;
 
       // send buffer
       int src = send(xsink, "Socket", "send", buf, rc, timeout_ms);
@@ -574,6 +694,606 @@ int qore_socket_private::send(int fd, qore_offset_t size, int timeout_ms, Except
    return rc;
 }
 
+qore_offset_t qore_socket_private::sendvIntern(ExceptionSink* xsink, const char* cname, const char* mname, const char* b1, qore_size_t s1, const char* b2, qore_size_t s2, int timeout_ms, int64& total) {
+   assert(xsink);
+   if (ssl) {
+      // coalesce small messages into a single TLS record
+      if (s1 + s2 <= QORE_SSL_COALESCE_SIZE) {
+         char buf[QORE_SSL_COALESCE_SIZE];
+         memcpy(buf, b1, s1);
+         memcpy(buf + s1, b2, s2);
+         return sendIntern(xsink, cname, mname, buf, s1 + s2, timeout_ms, total);
+      }
+      qore_offset_t rc = sendIntern(xsink, cname, mname, b1, s1, timeout_ms, total);
+      if (rc < 0 || sock == QORE_INVALID_SOCKET)
+         return rc;
+      return sendIntern(xsink, cname, mname, b2, s2, timeout_ms, total);
+   }
+
+#ifdef QORE_USE_WRITEV
+   qore_size_t size = s1 + s2;
+   qore_size_t bs = 0;
+   qore_offset_t rc;
+
+   // set the non-blocking flag
+   bool nb = (timeout_ms >= 0);
+
+   while (true) {
+      struct iovec iov[2];
+      int cnt;
+      if (bs < s1) {
+         iov[0].iov_base = (void*)(b1 + bs);
+         iov[0].iov_len = s1 - bs;
+         iov[1].iov_base = (void*)b2;
+         iov[1].iov_len = s2;
+         cnt = 2;
+      }
+      else {
+         iov[0].iov_base = (void*)(b2 + (bs - s1));
+         iov[0].iov_len = size - bs;
+         cnt = 1;
+      }
+
+      while (true) {
+         rc = ::writev(sock, iov, cnt);
+         // try again if we were interrupted by a signal
+         if (rc >= 0)
+            break;
+         sock_get_error();
+         // check that the send finishes before the timeout if we are using non-blocking I/O
+         if (nb && (errno == EAGAIN
+#ifdef EWOULDBLOCK
+                    || errno == EWOULDBLOCK
+#endif
+                )) {
+            if (!isWriteFinished(timeout_ms, mname, xsink)) {
+               if (*xsink)
+                  return -1;
+               se_timeout("Socket", mname, timeout_ms, xsink);
+               rc = QSE_TIMEOUT;
+               break;
+            }
+            continue;
+         }
+         if (errno != EINTR) {
+            xsink->raiseErrnoException("SOCKET-SEND-ERROR", errno, "error while executing %s::%s()", cname, mname);
+#ifdef EPIPE
+            if (errno == EPIPE)
+               close();
+#endif
+#ifdef ECONNRESET
+            if (errno == ECONNRESET)
+               close();
+#endif
+            break;
+         }
+      }
+
+      if (rc < 0 || sock == QORE_INVALID_SOCKET)
+         break;
+
+      total += rc;
+      bs += rc;
+
+      do_send_event(rc, bs, size);
+
+      if (bs >= size)
+         break;
+   }
+
+   return rc;
+#else
+   qore_offset_t rc = sendIntern(xsink, cname, mname, b1, s1, timeout_ms, total);
+   if (rc < 0 || sock == QORE_INVALID_SOCKET)
+      return rc;
+   return sendIntern(xsink, cname, mname, b2, s2, timeout_ms, total);
+#endif
+}
+
+int qore_socket_private::sendFileIntern(ExceptionSink* xsink, const char* cname, const char* mname, int fd, int64 size, int timeout_ms, int64& total) {
+#ifdef QORE_USE_SENDFILE
+   assert(!ssl);
+   // sendfile() only works with regular files as the source; other descriptors are read and sent normally
+   struct stat sbuf;
+   if (fstat(fd, &sbuf) || !S_ISREG(sbuf.st_mode))
+      return 1;
+
+   // set the non-blocking flag
+   bool nb = (timeout_ms >= 0);
+
+   int64 sent = 0;
+   while (size < 0 || sent < size) {
+      size_t bn = size < 0 ? QORE_SENDFILE_CHUNK : QORE_MIN(size - sent, QORE_SENDFILE_CHUNK);
+      ssize_t rc = ::sendfile(sock, fd, nullptr, bn);
+      if (rc < 0) {
+         sock_get_error();
+         if (errno == EINTR)
+            continue;
+         // check that the send finishes before the timeout if we are using non-blocking I/O
+         if (nb && (errno == EAGAIN
+#ifdef EWOULDBLOCK
+                    || errno == EWOULDBLOCK
+#endif
+                )) {
+            if (!isWriteFinished(timeout_ms, mname, xsink)) {
+               if (!*xsink)
+                  se_timeout(cname, mname, timeout_ms, xsink);
+               return -1;
+            }
+            continue;
+         }
+         // fall back to read() and send() if the file or socket does not support sendfile()
+         if (!sent && (errno == EINVAL || errno == ENOSYS))
+            return 1;
+         xsink->raiseErrnoException("SOCKET-SEND-ERROR", errno, "error while executing %s::%s()", cname, mname);
+#ifdef EPIPE
+         if (errno == EPIPE)
+            close();
+#endif
+#ifdef ECONNRESET
+         if (errno == ECONNRESET)
+            close();
+#endif
+         return -1;
+      }
+
+      // end of file
+      if (!rc)
+         break;
+
+      sent += rc;
+      total += rc;
+
+      do_send_event(rc, sent, size < 0 ? sent : size);
+   }
+
+   return 0;
+#else
+   return 1;
+#endif
+}
+
+int qore_socket_private::sendFromFileInputStream(InputStream* is, int64 size, int64 timeout, int64& total, ExceptionSink* xsink) {
+#ifdef QORE_USE_SENDFILE
+   if (ssl)
+      return 1;
+   FileInputStream* fis = dynamic_cast<FileInputStream*>(is);
+   if (!fis)
+      return 1;
+
+   int64 start = total;
+   int rc = sendFileIntern(xsink, "Socket", "sendFromInputStream", fis->getFile().getFD(), size, timeout, total);
+   if (!rc && size >= 0 && (total - start) < size) {
+      // not all size bytes were sent
+      xsink->raiseException("SOCKET-SEND-ERROR", "Unexpected end of stream");
+      return -1;
+   }
+   return rc;
+#else
+   return 1;
+#endif
+}
+
+int qore_socket_private::setReadBufferSize(int64 size, ExceptionSink* xsink) {
+   if (size < 1 || size > QORE_SOCKET_MAX_READ_BUFSIZE) {
+      xsink->raiseException("SOCKET-BUFFER-ERROR", "invalid read buffer size " QLLD "; expecting a value from 1 to %d", size, QORE_SOCKET_MAX_READ_BUFSIZE);
+      return -1;
+   }
+   if (buflen > (qore_size_t)size) {
+      xsink->raiseException("SOCKET-BUFFER-ERROR", "cannot set the read buffer size to " QLLD " bytes; the buffer currently holds " QSD " bytes of unread data", size, buflen);
+      return -1;
+   }
+   if (!rbuf) {
+      rbuf_size = size;
+      return 0;
+   }
+
+   // move any buffered data to the start of the buffer
+   if (buflen && bufoffset)
+      memmove(rbuf, rbuf + bufoffset, buflen);
+   bufoffset = 0;
+
+   char* nbuf = (char*)realloc(rbuf, size);
+   if (!nbuf) {
+      xsink->outOfMemory();
+      return -1;
+   }
+   rbuf = nbuf;
+   rbuf_size = size;
+   return 0;
+}
+
+int qore_socket_private::acceptBatch(ExceptionSink* xsink, std::vector<int>& fds, int max, int timeout_ms) {
+   assert(xsink);
+   if (sock == QORE_INVALID_SOCKET) {
+      se_not_open("Socket", "acceptBatch", xsink);
+      return QSE_NOT_OPEN;
+   }
+   if (in_op >= 0) {
+      if (in_op == gettid()) {
+         se_in_op("Socket", "acceptBatch", xsink);
+         return QSE_IN_OP;
+      }
+      se_in_op_thread("Socket", "acceptBatch", xsink);
+      return QSE_IN_OP_THREAD;
+   }
+
+   if (!isSocketDataAvailable(timeout_ms, "acceptBatch", xsink))
+      return *xsink ? -1 : 0;
+
+   // the listening socket is made non-blocking while accepting so that the loop stops when no more connections are
+   // pending and a connection reset before it is accepted cannot block the call
+   if (set_non_blocking(true, xsink))
+      return -1;
+
+   int err = 0;
+   while ((int)fds.size() < max) {
+#if defined HAVE_ACCEPT4 && defined SOCK_CLOEXEC
+      // the new descriptor is created close-on-exec in the same call
+      int rc = ::accept4(sock, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+      int rc = ::accept(sock, nullptr, nullptr);
+      // some platforms copy O_NONBLOCK from the listening socket to the new descriptor, which must be blocking
+      if (rc != QORE_INVALID_SOCKET) {
+#ifdef _Q_WINDOWS
+         u_long mode = 0;
+         if (check_windows_rc(ioctlsocket(rc, FIONBIO, &mode))) {
+            err = sock_get_error();
+            ::closesocket(rc);
+            break;
+         }
+#else
+         int arg = fcntl(rc, F_GETFL, 0);
+         if (arg < 0 || ((arg & O_NONBLOCK) && fcntl(rc, F_SETFL, arg & ~O_NONBLOCK) < 0)) {
+            err = errno;
+            ::close(rc);
+            break;
+         }
+#endif
+      }
+#endif
+      if (rc != QORE_INVALID_SOCKET) {
+         fds.push_back(rc);
+         continue;
+      }
+
+      err = sock_get_error();
+      // retry if interrupted by a signal or if the connection was reset while pending
+      if (err == EINTR || err == ECONNABORTED)
+         continue;
+      break;
+   }
+
+   if (set_non_blocking(false, xsink)) {
+      for (auto i : fds) {
+#ifdef _Q_WINDOWS
+         ::closesocket(i);
+#else
+         ::close(i);
+#endif
+      }
+      fds.clear();
+      return -1;
+   }
+
+   // errors are only raised if no connection was accepted; a persistent error will be raised by the next call
+   if (fds.empty() && err && err != EAGAIN && err != EWOULDBLOCK) {
+      errno = err;
+      qore_socket_error(xsink, "SOCKET-ACCEPT-ERROR", "error in accept()");
+      return -1;
+   }
+   return 0;
+}
+
+QoreSocket* qore_socket_private::newAccepted(int fd) const {
+   QoreSocket* s = new QoreSocket(fd, sfamily, stype, sprot, enc);
+   if (!socketname.empty())
+      s->priv->socketname = socketname;
+   // accepted sockets share the TLS/SSL context of the listening socket
+   if (ssl_ctx)
+      s->priv->setSSLContext(ssl_ctx);
+   // accepted sockets inherit the read buffer size of the listening socket
+   s->priv->rbuf_size = rbuf_size;
+   return s;
+}
+
+qore_offset_t qore_socket_private::brecvDirect(ExceptionSink* xsink, const char* meth, char* dest, qore_size_t bs, int timeout) {
+   assert(xsink);
+   assert(sock != QORE_INVALID_SOCKET);
+   assert(bs);
+
+   // buffered data is returned first; small reads that cannot be scattered go through the socket buffer
+#ifdef QORE_USE_WRITEV
+   bool buffered = buflen || (ssl && bs < rbuf_size);
+#else
+   bool buffered = buflen || bs < rbuf_size;
+#endif
+   if (buffered) {
+      char* buf;
+      qore_offset_t rc = brecv(xsink, meth, buf, bs, 0, timeout, false);
+      if (rc > 0)
+         memcpy(dest, buf, rc);
+      return rc;
+   }
+
+   qore_offset_t rc;
+   if (!ssl) {
+      if (timeout != -1 && !isDataAvailable(timeout, meth, xsink)) {
+         if (*xsink)
+            return -1;
+         se_timeout("Socket", meth, timeout, xsink);
+         return QSE_TIMEOUT;
+      }
+
+#ifdef QORE_USE_WRITEV
+      // read into the caller's buffer first; any additional data available is stored in the socket buffer
+      struct iovec iov[2];
+      iov[0].iov_base = dest;
+      iov[0].iov_len = bs;
+      iov[1].iov_base = getReadBuffer();
+      iov[1].iov_len = rbuf_size;
+#endif
+
+      while (true) {
+#ifdef QORE_USE_WRITEV
+         rc = ::readv(sock, iov, 2);
+#else
+         rc = ::recv(sock, dest, bs, 0);
+#endif
+         if (rc == QORE_SOCKET_ERROR) {
+            sock_get_error();
+            if (errno == EINTR)
+               continue;
+#ifdef ECONNRESET
+            if (errno == ECONNRESET) {
+               se_closed("Socket", meth, xsink);
+               close();
+            }
+            else
+#endif
+               qore_socket_error(xsink, "SOCKET-RECV-ERROR", "error in recv()", meth);
+         }
+         break;
+      }
+
+      if (rc > (qore_offset_t)bs) {
+         assert(!buflen);
+         buflen = rc - bs;
+         bufoffset = 0;
+         rc = bs;
+      }
+   }
+   else
+      rc = ssl->read(meth, dest, bs, timeout, xsink);
+
+   if (!rc)
+      close();
+
+   return rc;
+}
+
+char* qore_socket_private::recvSized(ExceptionSink* xsink, const char* meth, qore_size_t size, int timeout, qore_offset_t& rc, qore_size_t& len) {
+   assert(size);
+   len = 0;
+
+   // the buffer is not sized for the full amount immediately when the size is large so that a peer cannot cause a
+   // large allocation without sending the data
+   qore_size_t cap = QORE_MIN(size, (qore_size_t)QORE_SOCKET_MAX_PRESIZE);
+   char* buf = (char*)malloc(cap + 1);
+   if (!buf) {
+      xsink->outOfMemory();
+      rc = -1;
+      return nullptr;
+   }
+
+   while (len < size) {
+      if (len == cap) {
+         qore_size_t ncap = QORE_MIN(size, cap * 2);
+         char* nbuf = (char*)realloc(buf, ncap + 1);
+         if (!nbuf) {
+            xsink->outOfMemory();
+            rc = -1;
+            break;
+         }
+         buf = nbuf;
+         cap = ncap;
+      }
+
+      rc = brecvDirect(xsink, meth, buf + len, cap - len, timeout);
+      if (rc <= 0) {
+         printd(5, "qore_socket_private::recvSized(" QSD ", %d) len: " QSD " rc: " QSD " errno: %d (%s)\n", size, timeout, len, rc, errno, strerror(errno));
+         break;
+      }
+      len += rc;
+
+      // register event
+      do_read_event(rc, len, size);
+   }
+
+   buf[len] = '\0';
+   return buf;
+}
+
+int qore_socket_private::recvExact(ExceptionSink* xsink, const char* meth, char* dest, qore_size_t size, int timeout) {
+   qore_size_t br = 0;
+   while (br < size) {
+      qore_offset_t rc = brecvDirect(xsink, meth, dest + br, size - br, timeout);
+      if (rc <= 0) {
+         do_read_error(rc, meth, timeout, xsink);
+         return -1;
+      }
+      br += rc;
+   }
+   return 0;
+}
+
+QoreHashNode* qore_socket_private::readWebSocketMessage(ExceptionSink* xsink, int timeout, int64 max_size) {
+   assert(xsink);
+   const char* meth = "readWebSocketMessage";
+   if (sock == QORE_INVALID_SOCKET) {
+      se_not_open("Socket", meth, xsink);
+      return nullptr;
+   }
+   if (in_op >= 0) {
+      if (in_op == gettid()) {
+         se_in_op("Socket", meth, xsink);
+         return nullptr;
+      }
+      se_in_op_thread("Socket", meth, xsink);
+      return nullptr;
+   }
+
+   PrivateQoreSocketThroughputHelper th(this, false);
+   qore_size_t total = 0;
+
+   while (true) {
+      unsigned char hdr[QORE_WS_MAX_HEADER];
+      if (recvExact(xsink, meth, (char*)hdr, 2, timeout))
+         break;
+
+      int op = hdr[0] & 0xf;
+      bool fin = hdr[0] & QORE_WS_FIN;
+      bool masked = hdr[1] & QORE_WS_MASKED;
+      uint64_t len = hdr[1] & 0x7f;
+
+      // read the extended payload length and the mask
+      size_t el = len == 126 ? 2 : (len == 127 ? 8 : 0);
+      if (el || masked) {
+         if (recvExact(xsink, meth, (char*)hdr + 2, el + (masked ? 4 : 0), timeout))
+            break;
+         if (el) {
+            len = 0;
+            for (size_t i = 0; i < el; ++i)
+               len = (len << 8) | hdr[2 + i];
+         }
+      }
+      const unsigned char* mask = masked ? hdr + 2 + el : nullptr;
+      total += 2 + el + (masked ? 4 : 0);
+
+      bool control = op & 0x8;
+      if (control) {
+         if (!fin || len > 125) {
+            xsink->raiseException("WEBSOCKET-PROTOCOL-ERROR", "invalid control frame received with opcode %d (fin: %s, payload length: " QLLD ")", op, fin ? "true" : "false", (int64)len);
+            break;
+         }
+      }
+      else if (op == QORE_WSOP_CONTINUATION) {
+         if (!ws_frag) {
+            xsink->raiseException("WEBSOCKET-PROTOCOL-ERROR", "continuation frame received without an initial data frame");
+            break;
+         }
+      }
+      else if (ws_frag) {
+         xsink->raiseException("WEBSOCKET-PROTOCOL-ERROR", "data frame with opcode %d received before the end of a fragmented message", op);
+         break;
+      }
+      if (len & (1ULL << 63)) {
+         xsink->raiseException("WEBSOCKET-PROTOCOL-ERROR", "invalid frame payload length received");
+         break;
+      }
+
+      // the payload of continuation frames is read directly into the message being reassembled
+      BinaryNode* b;
+      SimpleRefHolder<BinaryNode> holder;
+      if (!control && ws_frag)
+         b = ws_frag;
+      else
+         holder = b = new BinaryNode;
+
+      qore_size_t off = b->size();
+      if (max_size > 0 && (uint64_t)max_size - off < len) {
+         xsink->raiseException("WEBSOCKET-MESSAGE-TOO-BIG", "message size " QLLD " exceeds the maximum of " QLLD " bytes", (int64)(off + len), max_size);
+         break;
+      }
+
+      // the buffer is extended as data arrives so that a peer cannot cause a large allocation without sending the
+      // data; one extra byte is reserved for the terminating null of text messages
+      qore_size_t done = 0;
+      while (done < len) {
+         qore_size_t n = QORE_MIN((qore_size_t)(len - done), (qore_size_t)QORE_SOCKET_MAX_PRESIZE);
+         if (b->preallocate(off + done + n + 1)) {
+            xsink->outOfMemory();
+            break;
+         }
+         unsigned char* p = (unsigned char*)b->getPtr() + off + done;
+         if (recvExact(xsink, meth, (char*)p, n, timeout))
+            break;
+         // chunks are a multiple of 4 bytes, so each chunk starts at the beginning of the mask
+         if (mask)
+            q_ws_mask(p, p, n, mask);
+         done += n;
+         total += n;
+         do_read_event(n, done, len);
+      }
+      if (*xsink)
+         break;
+      b->setSize(off + len);
+
+      if (!control && !fin) {
+         // the first frame of a fragmented message
+         if (!ws_frag) {
+            ws_frag = holder.release();
+            ws_frag_op = op;
+         }
+         continue;
+      }
+
+      if (op == QORE_WSOP_CONTINUATION) {
+         holder = ws_frag;
+         op = ws_frag_op;
+         ws_frag = nullptr;
+      }
+
+      th.finalize(total);
+      return getWebSocketMessage(op, masked, holder.release());
+   }
+
+   // the stream cannot be resynchronized after an error, so any partial message is discarded
+   if (ws_frag) {
+      ws_frag->deref();
+      ws_frag = nullptr;
+   }
+   th.finalize(total);
+   return nullptr;
+}
+
+QoreHashNode* qore_socket_private::getWebSocketMessage(int op, bool masked, BinaryNode* b) {
+   SimpleRefHolder<BinaryNode> holder(b);
+
+   QoreHashNode* h = new QoreHashNode;
+   h->setKeyValue("op", new QoreBigIntNode(op), 0);
+   h->setKeyValue("masked", get_bool_node(masked), 0);
+
+   qore_size_t size = b->size();
+   if (op == QORE_WSOP_CLOSE) {
+      // https://tools.ietf.org/html/rfc6455#section-7.1.5
+      // If this Close control frame contains no status code, _The WebSocket Connection Close Code_ is considered to be 1005
+      if (size < 2)
+         h->setKeyValue("close", new QoreBigIntNode(QORE_WSCC_NO_STATUS_RCVD), 0);
+      else {
+         // the close code is an unsigned 2-byte integer in network byte order
+         const unsigned char* p = (const unsigned char*)b->getPtr();
+         h->setKeyValue("close", new QoreBigIntNode((p[0] << 8) | p[1]), 0);
+         if (size > 2)
+            h->setKeyValue("msg", new QoreStringNode((const char*)p + 2, size - 2, QCS_UTF8), 0);
+      }
+   }
+   else if (op == QORE_WSOP_TEXT) {
+      // the string takes over the buffer
+      char* p = (char*)b->giveBuffer();
+      if (p) {
+         p[size] = '\0';
+         h->setKeyValue("msg", new QoreStringNode(p, size, size + 1, enc), 0);
+      }
+      else
+         h->setKeyValue("msg", new QoreStringNode("", enc), 0);
+   }
+   else
+      h->setKeyValue("msg", holder.release(), 0);
+
+   return h;
+}
+
 int qore_socket_private::recv(int fd, qore_offset_t size, int timeout_ms, ExceptionSink* xsink) {
    assert(xsink);
    if (!size)
@@ -589,13 +1309,13 @@ int qore_socket_private::recv(int fd, qore_offset_t size, int timeout_ms, Except
    qore_offset_t rc;
    while (true) {
       // calculate bytes needed
-      int bn;
+      qore_size_t bn;
       if (size == -1)
-	 bn = DEFAULT_SOCKET_BUFSIZE;
+	 bn = rbuf_size;
       else {
 	 bn = size - br;
-	 if (bn > DEFAULT_SOCKET_BUFSIZE)
-	    bn = DEFAULT_SOCKET_BUFSIZE;
+	 if (bn > rbuf_size)
+	    bn = rbuf_size;
       }
 
       rc = brecv(xsink, "recv", buf, bn, 0, timeout_ms);
@@ -1004,6 +1724,238 @@ long QoreSocket::verifyPeerCertificate() const {
 }
 
 // hardcoded to SOCK_STREAM (tcp only)
+#ifdef QORE_PARALLEL_CONNECT
+int qore_socket_private::connectINETParallel(const char* host, const char* service, const struct addrinfo* aip, int prt, int timeout_ms, ExceptionSink* xsink) {
+   // interleave address families starting with the family of the first address
+   std::vector<const struct addrinfo*> addrs;
+   {
+      std::vector<const struct addrinfo*> first, second;
+      for (const struct addrinfo* p = aip; p; p = p->ai_next)
+         (p->ai_family == aip->ai_family ? first : second).push_back(p);
+      for (size_t i = 0; i < first.size() || i < second.size(); ++i) {
+         if (i < first.size())
+            addrs.push_back(first[i]);
+         if (i < second.size())
+            addrs.push_back(second[i]);
+      }
+   }
+
+   // pending connection attempts
+   std::vector<pollfd> pfds;
+   std::vector<const struct addrinfo*> pai;
+   // the timeout applies to each connection attempt as with serial connections, so each pending attempt has its
+   // own deadline
+   std::vector<int64> pdeadline;
+
+   size_t next = 0;
+   int64 next_attempt = 0;
+   int err = 0;
+   bool timed_out = false;
+
+   int fd = QORE_INVALID_SOCKET;
+   const struct addrinfo* cai = nullptr;
+
+   while (fd == QORE_INVALID_SOCKET) {
+      int64 now = q_clock_getmillis();
+
+      // start the next connection attempt when it is due or when no attempt is pending
+      if (next < addrs.size() && (pfds.empty() || now >= next_attempt)) {
+         const struct addrinfo* p = addrs[next++];
+         int s = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+         if (s == QORE_INVALID_SOCKET) {
+            err = errno;
+            continue;
+         }
+         int arg = fcntl(s, F_GETFL, 0);
+         if (arg < 0 || fcntl(s, F_SETFL, arg | O_NONBLOCK) < 0) {
+            err = errno;
+            ::close(s);
+            continue;
+         }
+
+         do_connect_event(p->ai_family, p->ai_addr, host, service, prt);
+
+         int rc;
+         while ((rc = ::connect(s, p->ai_addr, p->ai_addrlen)) && errno == EINTR) {
+         }
+         if (!rc) {
+            fd = s;
+            cai = p;
+            break;
+         }
+         if (errno != EINPROGRESS) {
+            err = errno;
+            ::close(s);
+            continue;
+         }
+
+         pollfd pfd = {s, POLLOUT, 0};
+         pfds.push_back(pfd);
+         pai.push_back(p);
+         pdeadline.push_back(timeout_ms >= 0 ? now + timeout_ms : -1);
+         next_attempt = now + QORE_CONNECT_ATTEMPT_DELAY;
+         continue;
+      }
+
+      // all connection attempts failed
+      if (pfds.empty())
+         break;
+
+      // abandon pending attempts that have timed out
+      if (timeout_ms >= 0) {
+         for (size_t i = 0; i < pfds.size();) {
+            if (pdeadline[i] > now) {
+               ++i;
+               continue;
+            }
+            ::close(pfds[i].fd);
+            pfds.erase(pfds.begin() + i);
+            pai.erase(pai.begin() + i);
+            pdeadline.erase(pdeadline.begin() + i);
+            err = ETIMEDOUT;
+            // start the next attempt immediately after a timeout
+            next_attempt = now;
+         }
+         // the pending attempts were all abandoned in this pass
+         if (pfds.empty()) {
+            // continue with the remaining addresses, if any
+            if (next < addrs.size())
+               continue;
+            timed_out = true;
+            break;
+         }
+      }
+
+      // wait for a connection, the next connection attempt, or the first pending attempt to time out
+      int64 wait = next < addrs.size() ? QORE_MAX(next_attempt - now, 0ll) : -1;
+      if (timeout_ms >= 0) {
+         int64 left = *std::min_element(pdeadline.begin(), pdeadline.end()) - now;
+         if (wait < 0 || left < wait)
+            wait = left;
+      }
+
+      int rc = poll(&pfds[0], pfds.size(), (int)wait);
+      if (rc < 0) {
+         if (errno == EINTR)
+            continue;
+         err = errno;
+         break;
+      }
+
+      for (size_t i = 0; i < pfds.size();) {
+         if (!pfds[i].revents) {
+            ++i;
+            continue;
+         }
+
+         int val = 0;
+         socklen_t lon = sizeof(int);
+         if (getsockopt(pfds[i].fd, SOL_SOCKET, SO_ERROR, (GETSOCKOPT_ARG_4)(&val), &lon) < 0)
+            val = errno;
+
+         if (!val) {
+            fd = pfds[i].fd;
+            cai = pai[i];
+         }
+         else {
+            err = val;
+            ::close(pfds[i].fd);
+            // start the next attempt immediately after a failure
+            next_attempt = now;
+         }
+         pfds.erase(pfds.begin() + i);
+         pai.erase(pai.begin() + i);
+         pdeadline.erase(pdeadline.begin() + i);
+         if (!val)
+            break;
+      }
+   }
+
+   // close all other pending attempts
+   for (auto& i : pfds)
+      ::close(i.fd);
+
+   if (fd == QORE_INVALID_SOCKET) {
+      if (timed_out)
+         xsink->raiseException("SOCKET-CONNECT-ERROR", "timeout in connection to %s:%s after %dms", host, service, timeout_ms);
+      else {
+         errno = err;
+         qore_socket_error(xsink, "SOCKET-CONNECT-ERROR", "error in connect()", 0, host, service);
+      }
+      return -1;
+   }
+
+   sock = fd;
+   if (set_non_blocking(false, xsink))
+      return close_and_exit();
+
+   sfamily = cai->ai_family;
+   stype = cai->ai_socktype;
+   sprot = cai->ai_protocol;
+   port = prt;
+
+   do_connected_event();
+   return 0;
+}
+#endif
+
+namespace {
+// arguments for background DNS lookups
+struct qore_resolve_arg {
+   std::string host, service;
+   bool has_service;
+   int family;
+   // the event queue for lookup events, if any
+   Queue* q;
+   // the socket ID for events
+   int64 id;
+
+   qore_resolve_arg(const char* n_host, const char* n_service, int n_family, Queue* n_q, int64 n_id) :
+      host(n_host), service(n_service ? n_service : ""), has_service(n_service), family(n_family), q(n_q), id(n_id) {
+   }
+};
+}
+
+static void qore_resolve_thread(ExceptionSink* xsink, void* arg) {
+   std::unique_ptr<qore_resolve_arg> ra((qore_resolve_arg*)arg);
+   const char* service = ra->has_service ? ra->service.c_str() : nullptr;
+
+   if (ra->q)
+      qore_socket_private::post_resolve_event(ra->q, ra->id, ra->host.c_str(), service);
+
+   dns_entry_t e = QDC.resolve(ra->host.c_str(), service, ra->family);
+
+   if (ra->q) {
+      if (e->status) {
+         QoreHashNode* h = new QoreHashNode;
+         h->setKeyValue("event", new QoreBigIntNode(QORE_EVENT_HOSTNAME_RESOLVED), 0);
+         h->setKeyValue("source", new QoreBigIntNode(QORE_SOURCE_SOCKET), 0);
+         h->setKeyValue("id", new QoreBigIntNode(ra->id), 0);
+         h->setKeyValue("name", new QoreStringNode(ra->host), 0);
+         h->setKeyValue("error", new QoreStringNode(gai_strerror(e->status)), 0);
+         ra->q->pushAndTakeRef(h);
+      }
+      else {
+         for (struct addrinfo* p = e->ai; p; p = p->ai_next)
+            qore_socket_private::post_resolved_event(ra->q, ra->id, p->ai_addr);
+      }
+      ra->q->deref(xsink);
+   }
+}
+
+int qore_socket_private::resolveAsync(const char* host, const char* service, int family, ExceptionSink* xsink) {
+   if (cb_queue)
+      cb_queue->ref();
+   qore_resolve_arg* ra = new qore_resolve_arg(host, service, family, cb_queue, (int64)this);
+   if (q_start_thread(xsink, qore_resolve_thread, ra) < 0) {
+      if (cb_queue)
+         cb_queue->deref(xsink);
+      delete ra;
+      return -1;
+   }
+   return 0;
+}
+
 int QoreSocket::connectINET(const char* host, int prt, int timeout_ms, ExceptionSink* xsink) {
    QoreString service;
    service.sprintf("%d", prt);
@@ -1569,13 +2521,13 @@ int QoreSocket::recv(int fd, qore_offset_t size, int timeout) {
    qore_offset_t rc;
    while (true) {
       // calculate bytes needed
-      int bn;
+      qore_size_t bn;
       if (size == -1)
-	 bn = DEFAULT_SOCKET_BUFSIZE;
+	 bn = priv->rbuf_size;
       else {
 	 bn = size - br;
-	 if (bn > DEFAULT_SOCKET_BUFSIZE)
-	    bn = DEFAULT_SOCKET_BUFSIZE;
+	 if (bn > priv->rbuf_size)
+	    bn = priv->rbuf_size;
       }
 
       rc = priv->brecv(&xsink, "recv", buf, bn, 0, timeout);
@@ -1905,10 +2857,7 @@ QoreSocket* QoreSocket::accept(SocketSource* source, ExceptionSink* xsink) {
    if (rc < 0)
       return 0;
 
-   QoreSocket* s = new QoreSocket(rc, priv->sfamily, priv->stype, priv->sprot, priv->enc);
-   if (!priv->socketname.empty())
-      s->priv->socketname = priv->socketname;
-   return s;
+   return priv->newAccepted(rc);
 }
 
 // QoreSocket::acceptSSL()
@@ -1949,11 +2898,8 @@ QoreSocket* QoreSocket::accept(int timeout_ms, ExceptionSink* xsink) {
    int rc = priv->accept_internal(xsink, 0, timeout_ms);
    if (rc < 0)
       return nullptr;
-   QoreSocket* s = new QoreSocket(rc, priv->sfamily, priv->stype, priv->sprot, priv->enc);
-   if (!priv->socketname.empty())
-      s->priv->socketname = priv->socketname;
 
-   return s;
+   return priv->newAccepted(rc);
 }
 
 QoreSocket* QoreSocket::acceptSSL(int timeout_ms, X509* cert, EVP_PKEY* pkey, ExceptionSink* xsink) {
@@ -2121,6 +3067,10 @@ bool QoreSocket::pendingHttpChunkedBody() const {
    return priv->pendingHttpChunkedBody();
 }
 
+bool QoreSocket::isHttpMessageBuffered(ExceptionSink* xsink) {
+   return priv->isHttpMessageBuffered("isHttpMessageBuffered", xsink);
+}
+
 void QoreSocket::setSslVerifyMode(int mode) {
    priv->setSslVerifyMode(mode);
 }
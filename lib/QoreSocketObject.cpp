@@ -371,6 +371,13 @@ AbstractQoreNode* QoreSocketObject::readHTTPHeader(ExceptionSink* xsink, QoreHas
    return priv->socket->readHTTPHeader(xsink, info, timeout_ms);
 }
 
+QoreHashNode* QoreSocketObject::readHTTPHeader(ExceptionSink* xsink, QoreHashNode* info, int timeout_ms, bool set_encoding) {
+   AutoLocker al(priv->m);
+   qore_offset_t rc;
+   // qore_socket_private::readHTTPHeader() always returns a QoreHashNode* (or 0) if an ExceptionSink argument is passed
+   return static_cast<QoreHashNode*>(priv->socket->priv->readHTTPHeader(xsink, info, timeout_ms, rc, QORE_SOURCE_SOCKET, set_encoding));
+}
+
 QoreStringNode* QoreSocketObject::readHTTPHeaderString(ExceptionSink* xsink, int timeout_ms) {
    AutoLocker al(priv->m);
    return priv->socket->readHTTPHeaderString(xsink, timeout_ms);
@@ -431,6 +438,71 @@ long QoreSocketObject::verifyPeerCertificate() {
    return priv->socket->verifyPeerCertificate();
 }
 
+void QoreSocketObject::setSSLContext(QoreSSLContext* ctx) {
+   AutoLocker al(priv->m);
+   priv->socket->priv->setSSLContext(ctx);
+}
+
+bool QoreSocketObject::isSSLSessionReused() const {
+   AutoLocker al(priv->m);
+   return priv->socket->priv->ssl ? priv->socket->priv->ssl->sessionReused() : false;
+}
+
+int QoreSocketObject::setReadBufferSize(int64 size, ExceptionSink* xsink) {
+   AutoLocker al(priv->m);
+   return priv->socket->priv->setReadBufferSize(size, xsink);
+}
+
+int64 QoreSocketObject::getReadBufferSize() const {
+   AutoLocker al(priv->m);
+   return priv->socket->priv->getReadBufferSize();
+}
+
+bool QoreSocketObject::hasBufferedData() const {
+   if (priv->m.trylock())
+      return false;
+   bool rc = priv->socket->priv->hasBufferedData();
+   priv->m.unlock();
+   return rc;
+}
+
+int QoreSocketObject::resolveAsync(const char* host, const char* service, int family, ExceptionSink* xsink) {
+   AutoLocker al(priv->m);
+   return priv->socket->priv->resolveAsync(host, service, family, xsink);
+}
+
+QoreHashNode* QoreSocketObject::readWebSocketMessage(int timeout_ms, int64 max_size, ExceptionSink* xsink) {
+   AutoLocker al(priv->m);
+   return priv->socket->priv->readWebSocketMessage(xsink, timeout_ms, max_size);
+}
+
+int QoreSocketObject::acceptBatch(std::vector<QoreSocketObject*>& rv, int max, int timeout_ms, ExceptionSink* xsink) {
+   std::vector<int> fds;
+   AutoLocker al(priv->m);
+   if (priv->socket->priv->acceptBatch(xsink, fds, max, timeout_ms))
+      return -1;
+   for (auto i : fds)
+      rv.push_back(new QoreSocketObject(priv->socket->priv->newAccepted(i), priv->cert ? priv->cert->certRefSelf() : 0, priv->pk ? priv->pk->pkRefSelf() : 0));
+   return 0;
+}
+
+int QoreSocketObject::setReusePort(bool reuseport, ExceptionSink* xsink) {
+#ifndef SO_REUSEPORT
+   if (reuseport) {
+      xsink->raiseException("SOCKET-REUSEPORT-ERROR", "SO_REUSEPORT is not supported on this platform");
+      return -1;
+   }
+#endif
+   AutoLocker al(priv->m);
+   priv->socket->priv->reuseport = reuseport;
+   return 0;
+}
+
+bool QoreSocketObject::getReusePort() const {
+   AutoLocker al(priv->m);
+   return priv->socket->priv->reuseport;
+}
+
 int QoreSocketObject::getSocket() {
    return priv->socket->getSocket();
 }
@@ -611,6 +683,11 @@ bool QoreSocketObject::pendingHttpChunkedBody() const {
    return priv->socket->pendingHttpChunkedBody();
 }
 
+bool QoreSocketObject::isHttpMessageBuffered(ExceptionSink* xsink) {
+   AutoLocker al(priv->m);
+   return priv->socket->isHttpMessageBuffered(xsink);
+}
+
 void QoreSocketObject::setSslVerifyMode(int mode) {
    AutoLocker al(priv->m);
    priv->socket->setSslVerifyMode(mode);
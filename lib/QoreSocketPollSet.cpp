@@ -0,0 +1,303 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreSocketPollSet.cpp
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#include <qore/Qore.h>
+#include "qore/QoreSocketObject.h"
+#include "qore/intern/QoreSocketPollSet.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef QORE_USE_EPOLL
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+// the kernel set is only used with epoll
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+#endif
+
+#include <vector>
+
+// the maximum number of events returned by a single call if no limit is given
+#define QORE_POLLSET_MAX_EVENTS 1024
+
+QoreSocketPollSet::QoreSocketPollSet(bool n_edge, ExceptionSink* xsink) : edge(n_edge) {
+#ifdef QORE_USE_EPOLL
+   epfd = epoll_create1(EPOLL_CLOEXEC);
+   if (epfd < 0)
+      xsink->raiseErrnoException("SOCKETPOLLSET-ERROR", errno, "epoll_create1() failed");
+#endif
+}
+
+QoreSocketPollSet::~QoreSocketPollSet() {
+   assert(pmap.empty());
+#ifdef QORE_USE_EPOLL
+   if (epfd >= 0)
+      ::close(epfd);
+#endif
+}
+
+QoreSocketPollSet::poll_map_t::iterator QoreSocketPollSet::find(QoreObject* obj) {
+   for (poll_map_t::iterator i = pmap.begin(), e = pmap.end(); i != e; ++i) {
+      if (i->second.obj == obj)
+         return i;
+   }
+   return pmap.end();
+}
+
+int QoreSocketPollSet::ctl(int op, int fd, int events, ExceptionSink* xsink) {
+#ifdef QORE_USE_EPOLL
+   struct epoll_event ev;
+   ev.events = 0;
+   if (events & SOCK_POLLIN)
+      ev.events |= EPOLLIN | EPOLLRDHUP;
+   if (events & SOCK_POLLOUT)
+      ev.events |= EPOLLOUT;
+   if (edge)
+      ev.events |= EPOLLET;
+   ev.data.fd = fd;
+   int rc = epoll_ctl(epfd, op, fd, op == EPOLL_CTL_DEL ? nullptr : &ev);
+   if (rc && op == EPOLL_CTL_ADD && errno == EEXIST)
+      rc = epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+   if (rc) {
+      // descriptors are removed from the set automatically when closed
+      if (op == EPOLL_CTL_DEL && (errno == ENOENT || errno == EBADF))
+         return 0;
+      xsink->raiseErrnoException("SOCKETPOLLSET-ERROR", errno, "epoll_ctl() failed for socket descriptor %d", fd);
+      return -1;
+   }
+#endif
+   return 0;
+}
+
+void QoreSocketPollSet::del(poll_entry_t& e, ExceptionSink* xsink) {
+   e.sock->deref(xsink);
+   e.obj->deref(xsink);
+   e.arg.discard(xsink);
+}
+
+int QoreSocketPollSet::add(QoreObject* obj, QoreSocketObject* sock, int events, const QoreValue arg, ExceptionSink* xsink) {
+   if (!events || (events & ~(SOCK_POLLIN | SOCK_POLLOUT))) {
+      xsink->raiseException("SOCKETPOLLSET-ERROR", "invalid events value %d; expecting a combination of SOCK_POLLIN and SOCK_POLLOUT", events);
+      return -1;
+   }
+
+   int fd = sock->getSocket();
+   if (fd < 0) {
+      xsink->raiseException("SOCKETPOLLSET-ERROR", "cannot add a socket that is not open to the poll set");
+      return -1;
+   }
+
+   // an entry for a socket that was closed without being removed can have the same descriptor
+   poll_entry_t stale;
+   stale.obj = nullptr;
+   {
+      AutoLocker al(l);
+      if (find(obj) != pmap.end()) {
+         xsink->raiseException("SOCKETPOLLSET-ERROR", "the socket is already registered in the poll set");
+         return -1;
+      }
+      poll_map_t::iterator i = pmap.find(fd);
+      if (i != pmap.end()) {
+         stale = i->second;
+         pmap.erase(i);
+      }
+
+      if (!ctl(EPOLL_CTL_ADD, fd, events, xsink)) {
+         obj->ref();
+         sock->ref();
+         poll_entry_t& e = pmap[fd];
+         e.obj = obj;
+         e.sock = sock;
+         e.fd = fd;
+         e.events = events;
+         e.arg = arg.refSelf();
+      }
+   }
+
+   if (stale.obj)
+      del(stale, xsink);
+   return *xsink ? -1 : 0;
+}
+
+int QoreSocketPollSet::modify(QoreObject* obj, int events, ExceptionSink* xsink) {
+   if (!events || (events & ~(SOCK_POLLIN | SOCK_POLLOUT))) {
+      xsink->raiseException("SOCKETPOLLSET-ERROR", "invalid events value %d; expecting a combination of SOCK_POLLIN and SOCK_POLLOUT", events);
+      return -1;
+   }
+
+   AutoLocker al(l);
+   poll_map_t::iterator i = find(obj);
+   if (i == pmap.end()) {
+      xsink->raiseException("SOCKETPOLLSET-ERROR", "the socket is not registered in the poll set");
+      return -1;
+   }
+   if (ctl(EPOLL_CTL_MOD, i->first, events, xsink))
+      return -1;
+   i->second.events = events;
+   return 0;
+}
+
+bool QoreSocketPollSet::remove(QoreObject* obj, ExceptionSink* xsink) {
+   poll_entry_t e;
+   {
+      AutoLocker al(l);
+      poll_map_t::iterator i = find(obj);
+      if (i == pmap.end())
+         return false;
+      e = i->second;
+      pmap.erase(i);
+      ctl(EPOLL_CTL_DEL, e.fd, 0, xsink);
+   }
+   del(e, xsink);
+   return true;
+}
+
+void QoreSocketPollSet::clear(ExceptionSink* xsink) {
+   poll_map_t tmp;
+   {
+      AutoLocker al(l);
+      for (auto& i : pmap)
+         ctl(EPOLL_CTL_DEL, i.first, 0, xsink);
+      pmap.swap(tmp);
+   }
+   for (auto& i : tmp)
+      del(i.second, xsink);
+}
+
+size_t QoreSocketPollSet::size() const {
+   AutoLocker al(l);
+   return pmap.size();
+}
+
+QoreHashNode* QoreSocketPollSet::getEvent(const poll_entry_t& e, int revents) {
+   QoreHashNode* h = new QoreHashNode;
+   e.obj->ref();
+   h->setKeyValue("socket", e.obj, 0);
+   h->setKeyValue("events", new QoreBigIntNode(revents), 0);
+   h->setKeyValue("arg", e.arg.getReferencedValue(), 0);
+   return h;
+}
+
+QoreListNode* QoreSocketPollSet::wait(int timeout_ms, int max_events, ExceptionSink* xsink) {
+   if (max_events <= 0)
+      max_events = QORE_POLLSET_MAX_EVENTS;
+
+   // descriptor -> events ready
+   typedef std::map<int, int> ready_map_t;
+   ready_map_t ready;
+
+#ifndef QORE_USE_EPOLL
+   std::vector<pollfd> pfds;
+#endif
+   {
+      AutoLocker al(l);
+      for (auto& i : pmap) {
+         // data buffered in user space is not reported by the kernel; sockets with buffered data that are not
+         // returned in this call are reported again by the next call
+         if ((i.second.events & SOCK_POLLIN) && ready.size() < (size_t)max_events && i.second.sock->hasBufferedData())
+            ready[i.first] = SOCK_POLLIN;
+#ifndef QORE_USE_EPOLL
+         short ev = 0;
+         if (i.second.events & SOCK_POLLIN)
+            ev |= POLLIN;
+         if (i.second.events & SOCK_POLLOUT)
+            ev |= POLLOUT;
+         pollfd pfd = {i.first, ev, 0};
+         pfds.push_back(pfd);
+#endif
+      }
+   }
+
+   // do not wait if any socket already has data available
+   if (!ready.empty())
+      timeout_ms = 0;
+
+#ifdef QORE_USE_EPOLL
+   // edge-triggered events are not reported again, so the kernel is only asked for as many events as can be
+   // returned; the events returned may only add to the sockets already ready
+   int kmax = max_events - (int)ready.size();
+   std::vector<struct epoll_event> evs(kmax ? kmax : 1);
+   int rc = 0;
+   while (kmax && (rc = epoll_wait(epfd, &evs[0], kmax, timeout_ms)) < 0 && errno == EINTR) {
+   }
+   if (rc < 0) {
+      xsink->raiseErrnoException("SOCKETPOLLSET-ERROR", errno, "epoll_wait() failed");
+      return nullptr;
+   }
+   for (int i = 0; i < rc; ++i) {
+      int rev = 0;
+      if (evs[i].events & (EPOLLIN | EPOLLRDHUP))
+         rev |= SOCK_POLLIN;
+      if (evs[i].events & EPOLLOUT)
+         rev |= SOCK_POLLOUT;
+      if (evs[i].events & (EPOLLERR | EPOLLHUP))
+         rev |= SOCK_POLLERR;
+      ready[evs[i].data.fd] |= rev;
+   }
+#else
+   int rc;
+   while ((rc = ::poll(pfds.empty() ? nullptr : &pfds[0], pfds.size(), timeout_ms)) < 0 && errno == EINTR) {
+   }
+   if (rc < 0) {
+      xsink->raiseErrnoException("SOCKETPOLLSET-ERROR", errno, "poll() failed");
+      return nullptr;
+   }
+   for (auto& i : pfds) {
+      if (!i.revents)
+         continue;
+      int rev = 0;
+      if (i.revents & POLLIN)
+         rev |= SOCK_POLLIN;
+      if (i.revents & POLLOUT)
+         rev |= SOCK_POLLOUT;
+      if (i.revents & (POLLERR | POLLHUP | POLLNVAL))
+         rev |= SOCK_POLLERR;
+      ready[i.fd] |= rev;
+   }
+#endif
+
+   ReferenceHolder<QoreListNode> rv(new QoreListNode, xsink);
+   AutoLocker al(l);
+   for (auto& i : ready) {
+      // with poll(), events not returned are reported again by the next call
+      if (rv->size() == (size_t)max_events)
+         break;
+      // sockets removed while waiting are ignored
+      poll_map_t::iterator pi = pmap.find(i.first);
+      if (pi == pmap.end())
+         continue;
+      rv->push(getEvent(pi->second, i.second));
+   }
+   return rv.release();
+}
@@ -52,10 +52,12 @@
 
 #include <memory>
 #include <map>
+#include <algorithm>
+#include <climits>
 
 #define QB(x) ((x) ? "true" : "false")
 
-QoreZoneInfo::QoreZoneInfo(QoreString &root, std::string &n_name, ExceptionSink *xsink) : AbstractQoreZoneInfo(n_name), first_pos(-1), valid(false), std_abbr(0) {
+QoreZoneInfo::QoreZoneInfo(QoreString &root, std::string &n_name, ExceptionSink *xsink) : AbstractQoreZoneInfo(n_name), valid(false), std_abbr(0) {
    printd(5, "QoreZoneInfo::QoreZoneInfo() this: %p root: %s name: %s\n", this, root.getBuffer(), name.c_str());
 
    std::string fn = root.getBuffer();
@@ -124,8 +126,6 @@ QoreZoneInfo::QoreZoneInfo(QoreString &root, std::string &n_name, ExceptionSink
       if (f.readi4(&QoreDSTTransitions[i].time, xsink))
 	 return;
 
-      if (first_pos == -1 && QoreDSTTransitions[i].time >= 0)
-         first_pos = i;
       //printd(5, "QoreZoneInfo::QoreZoneInfo() trans_time[%d]: %u\n", i, QoreDSTTransitions[i].time);
    }
 
@@ -186,8 +186,6 @@ QoreZoneInfo::QoreZoneInfo(QoreString &root, std::string &n_name, ExceptionSink
                printd(1, "QoreZoneInfo::QoreZoneInfo() skipping invalid transition [%d] at %d\n", i, t.time);
                QoreDSTTransitions.erase(di);
                di = prev;
-               if ((int)i < first_pos)
-                 --first_pos;
             }
          }
          ++di;
@@ -343,49 +341,60 @@ int QoreTimeZoneManager::processIntern(const char *fn, ExceptionSink *xsink) {
    return processFile(fn, false, xsink) ? 0 : -1;
 }
 
-int QoreZoneInfo::getUTCOffsetImpl(int64 epoch_offset, bool &is_dst, const char *&zone_name) const {
-   //printf("QoreZoneInfo::getUTCOffsetImpl() epoch_offset: %lld first_pos: %d time: %lld\n", epoch_offset, first_pos, first_pos > 0 ? QoreDSTTransitions[first_pos - 1].time : -1ll);
-   unsigned i = 0;
-   if (first_pos > 0 && epoch_offset >= QoreDSTTransitions[first_pos - 1].time) {
-      i = first_pos - 1;
-      unsigned end = QoreDSTTransitions.size() - 1;
-      while (i < end) {
-         if (QoreDSTTransitions[i].time <= epoch_offset && QoreDSTTransitions[i + 1].time > epoch_offset) {
-            zone_name = QoreDSTTransitions[i].trans->abbr.c_str();
-            is_dst = QoreDSTTransitions[i].trans->isdst;
-
-            //printf("QoreZoneInfo::getUTCOffsetImpl(epoch: %lld) tt[<=]: %d tt[>]: %d zone_name: %s is_dst: %d utcoff: %d\n", epoch_offset, QoreDSTTransitions[i].time, QoreDSTTransitions[i + 1].time, zone_name, is_dst, QoreDSTTransitions[i].trans->utcoff);
-            return QoreDSTTransitions[i].trans->utcoff;
-         }
-         ++i;
-      }
-      // not found, time zone unknown
-      is_dst = false;
-      zone_name = std_abbr;
+// the last transition interval found in the current thread; dates are normally processed in runs
+// for the same zone and close together in time, so most lookups are satisfied without searching
+struct QoreZoneInfoCache {
+   const QoreZoneInfo* zone;
+   // the interval [start, end) in seconds from the epoch
+   int64 start, end;
+   int utcoff;
+   bool is_dst;
+   const char* zone_name;
+};
+
+static thread_local QoreZoneInfoCache zone_cache = {nullptr, 0, 0, 0, false, nullptr};
+
+void QoreZoneInfo::clearThreadCache() {
+   zone_cache.zone = nullptr;
+}
 
-      //printf("QoreZoneInfo::getUTCOffsetImpl(epoch: %lld) NOT FOUND zone_name: %s is_dst: %d utcoff: %d\n", epoch_offset, zone_name, is_dst, utcoff);
+static bool qore_dst_transition_before(int64 epoch_offset, const QoreDSTTransition& t) {
+   return epoch_offset < t.time;
+}
 
-      return utcoff;
+int QoreZoneInfo::getUTCOffsetImpl(int64 epoch_offset, bool &is_dst, const char *&zone_name) const {
+   QoreZoneInfoCache& c = zone_cache;
+   if (c.zone == this && epoch_offset >= c.start && epoch_offset < c.end) {
+      is_dst = c.is_dst;
+      zone_name = c.zone_name;
+      return c.utcoff;
    }
 
-   i = first_pos + 1;
-   while (i > 0) {
-      if (QoreDSTTransitions[i].time > epoch_offset && QoreDSTTransitions[i - 1].time <= epoch_offset) {
-         zone_name = QoreDSTTransitions[i].trans->abbr.c_str();
-         is_dst = QoreDSTTransitions[i].trans->isdst;
+   // find the first transition after the given time
+   dst_transition_vec_t::const_iterator i = std::upper_bound(QoreDSTTransitions.begin(), QoreDSTTransitions.end(), epoch_offset, qore_dst_transition_before);
 
-         //printf("QoreZoneInfo::getUTCOffsetImpl(epoch: %lld) i: %d tt[<=]: %d tt[>]: %d zone_name: %s is_dst: %d utcoff: %d\n", epoch_offset, i, QoreDSTTransitions[i].time, QoreDSTTransitions[i + 1].time, zone_name, is_dst, QoreDSTTransitions[i].trans->utcoff);
-         return QoreDSTTransitions[i].trans->utcoff;
-      }
-      --i;
+   c.zone = this;
+   if (i == QoreDSTTransitions.begin() || i == QoreDSTTransitions.end()) {
+      // not found, time zone unknown
+      c.start = i == QoreDSTTransitions.begin() ? LLONG_MIN : (i - 1)->time;
+      c.end = i == QoreDSTTransitions.end() ? LLONG_MAX : i->time;
+      c.utcoff = utcoff;
+      c.is_dst = false;
+      c.zone_name = std_abbr;
+   }
+   else {
+      const QoreDSTTransition& t = *(i - 1);
+      c.start = t.time;
+      c.end = i->time;
+      c.utcoff = t.trans->utcoff;
+      c.is_dst = t.trans->isdst;
+      c.zone_name = t.trans->abbr.c_str();
    }
-   // not found, time zone unknown
-   is_dst = false;
-   zone_name = std_abbr;
-
-   //printf("QoreZoneInfo::getUTCOffsetImpl(epoch: %lld) NOT FOUND zone_name: %s is_dst: %d utcoff: %d\n", epoch_offset, zone_name, is_dst, utcoff);
 
-   return utcoff;
+   //printf("QoreZoneInfo::getUTCOffsetImpl(epoch: %lld) tt[<=]: %lld tt[>]: %lld zone_name: %s is_dst: %d utcoff: %d\n", epoch_offset, c.start, c.end, c.zone_name, c.is_dst, c.utcoff);
+   is_dst = c.is_dst;
+   zone_name = c.zone_name;
+   return c.utcoff;
 }
 
 // format: S00[[:]00[[:]00]] (S is + or -)
@@ -0,0 +1,128 @@
+/* -*- mode: c++; indent-tabs-mode: nil -*- */
+/*
+  QoreWebSocket.cpp
+
+  Qore Programming Language
+
+  Copyright (C) 2003 - 2017 Qore Technologies, s.r.o.
+
+  Permission is hereby granted, free of charge, to any person obtaining a
+  copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom the
+  Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+  DEALINGS IN THE SOFTWARE.
+
+  Note that the Qore library is released under a choice of three open-source
+  licenses: MIT (as above), LGPL 2+, or GPL 2+; see README-LICENSE for more
+  information.
+*/
+
+#include <qore/Qore.h>
+#include "qore/intern/QoreWebSocket.h"
+
+#include <openssl/rand.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void q_ws_mask(unsigned char* dst, const unsigned char* src, size_t len, const unsigned char* mask) {
+   // the mask repeated over a 64-bit word; the byte order in memory is the same as the mask
+   uint32_t m32;
+   memcpy(&m32, mask, 4);
+   uint64_t m64 = ((uint64_t)m32 << 32) | m32;
+
+   size_t i = 0;
+#ifdef __SSE2__
+   __m128i m128 = _mm_set1_epi64x((long long)m64);
+   for (; i + 16 <= len; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+      _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, m128));
+   }
+#endif
+   for (; i + 8 <= len; i += 8) {
+      uint64_t v;
+      memcpy(&v, src + i, 8);
+      v ^= m64;
+      memcpy(dst + i, &v, 8);
+   }
+   // i is always a multiple of 4 here, so the mask starts again at the first byte
+   for (; i < len; ++i)
+      dst[i] = src[i] ^ mask[i & 3];
+}
+
+size_t q_ws_encode_header(unsigned char* hdr, int op, bool fin, size_t len, const unsigned char* mask) {
+   hdr[0] = (fin ? QORE_WS_FIN : 0) | (op & 0xf);
+   unsigned char m = mask ? QORE_WS_MASKED : 0;
+
+   size_t hl;
+   if (len < 126) {
+      hdr[1] = m | (unsigned char)len;
+      hl = 2;
+   }
+   else if (len < 65536) {
+      hdr[1] = m | 126;
+      hdr[2] = (unsigned char)(len >> 8);
+      hdr[3] = (unsigned char)len;
+      hl = 4;
+   }
+   else {
+      hdr[1] = m | 127;
+      uint64_t l = len;
+      for (int i = 9; i > 1; --i) {
+         hdr[i] = (unsigned char)l;
+         l >>= 8;
+      }
+      hl = 10;
+   }
+
+   if (mask) {
+      memcpy(hdr + hl, mask, 4);
+      hl += 4;
+   }
+   return hl;
+}
+
+BinaryNode* q_ws_encode_frame(const void* data, size_t len, int op, bool fin, bool masked) {
+   unsigned char mask[4];
+   if (masked) {
+      // the mask must not be predictable by the peer (RFC 6455 section 5.3)
+      if (RAND_bytes(mask, 4) != 1) {
+#ifdef HAVE_RANDOM
+         int32_t r = (int32_t)random();
+#else
+         int32_t r = (int32_t)rand();
+#endif
+         memcpy(mask, &r, 4);
+      }
+   }
+
+   // the frame is built in a single allocation with the payload copied or masked directly after the header
+   unsigned char* buf = (unsigned char*)malloc(QORE_WS_MAX_HEADER + len);
+   if (!buf)
+      return nullptr;
+   size_t hl = q_ws_encode_header(buf, op, fin, len, masked ? mask : nullptr);
+   if (len) {
+      if (masked)
+         q_ws_mask(buf + hl, (const unsigned char*)data, len, mask);
+      else
+         memcpy(buf + hl, data, len);
+   }
+   return new BinaryNode(buf, hl + len);
+}
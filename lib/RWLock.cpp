@@ -125,7 +125,7 @@ int RWLock::externWaitImpl(int mtid, QoreCondition *cond, ExceptionSink *xsink,
 int RWLock::grabImpl(int mtid, VLock *nvl, ExceptionSink *xsink, int64 timeout_ms) {
    // check for errors
    if (tid == mtid) {
-      xsink->raiseException("LOCK-ERROR", "TID %d tried to grab the write lock twice", tid);
+      xsink->raiseException("LOCK-ERROR", "TID %d tried to grab the write lock twice", mtid);
       return -1;
    }
    while (tid >= 0 || (tid == Lock_Unlocked && num_readers)) {
@@ -266,9 +266,7 @@ void RWLock::cleanupImpl() {
       tid = -1;
 
       // delete entry from the thread lock list
-      vl->pop(this);
-
-      vl = 0;
+      vl.exchange(nullptr)->pop(this);
       // wake up sleeping thread(s)
       signalImpl();
    }
@@ -286,7 +284,7 @@ int RWLock::releaseImpl(ExceptionSink *xsink) {
    }
    if (tid != mtid) {
       // use getName() here so it can be safely inherited
-      xsink->raiseException("LOCK-ERROR", "%s::writeUnlock() called by TID %d while the write lock is held by TID %d", getName(), mtid, tid);
+      xsink->raiseException("LOCK-ERROR", "%s::writeUnlock() called by TID %d while the write lock is held by TID %d", getName(), mtid, tid.load());
       return -1;
    }
    return 0;
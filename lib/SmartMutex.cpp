@@ -45,46 +45,65 @@ int SmartMutex::releaseImpl() {
    return 0;
 }
 
+bool SmartMutex::grabFastImpl(int mtid, int& rc) {
+   int t;
+   if (!cas_grab(mtid, t))
+      return false;
+   rc = 0;
+   return true;
+}
+
+bool SmartMutex::releaseFastImpl(int mtid, int& rc) {
+   // only the owner can change tid from its own TID, so errors are reported by the normal path
+   if (tid != mtid)
+      return false;
+   release_fast(mtid);
+   rc = 0;
+   return true;
+}
+
 int SmartMutex::grabImpl(int mtid, VLock *nvl, ExceptionSink *xsink, int64 timeout_ms) {
    if (tid == mtid) {
       // getName() for possible inheritance
-      xsink->raiseException("LOCK-ERROR", "TID %d called %s::lock() twice without an intervening %s::unlock()", tid, getName(), getName());
+      xsink->raiseException("LOCK-ERROR", "TID %d called %s::lock() twice without an intervening %s::unlock()", mtid, getName(), getName());
       return -1;
    }
-   while (tid >= 0) {
+   int t;
+   while (!cas_grab(mtid, t)) {
+      if (t == Lock_Deleted) {
+         // getName() for possible inheritance
+         xsink->raiseException("LOCK-ERROR", "%s has been deleted in another thread", getName());
+         return -1;
+      }
       waiting++;
-      int rc =  nvl->waitOn((AbstractSmartLock *)this, vl, xsink, timeout_ms);
+      // the lock can be released without asl_lock, so check again after incrementing the waiting count
+      int rc = tid == Lock_Unlocked ? 0 : nvl->waitOn((AbstractSmartLock *)this, vl, xsink, timeout_ms);
       waiting--;
       if (rc)
 	 return -1;
    }
-   if (tid == Lock_Deleted) {
-      // getName() for possible inheritance
-      xsink->raiseException("LOCK-ERROR", "%s has been deleted in another thread", getName());
-      return -1;
-   }
    return 0;
 }
 
 int SmartMutex::releaseImpl(ExceptionSink *xsink) {
    int mtid = gettid();
-   if (tid < 0) {
+   int t = tid;
+   if (t < 0) {
       // getName() for possible inheritance
       xsink->raiseException("LOCK-ERROR", "TID %d called %s::unlock() while the lock was already unlocked", mtid, getName());
       return -1;
    }
-   if (tid != mtid) {
+   if (t != mtid) {
       // getName() for possible inheritance
-      xsink->raiseException("LOCK-ERROR", "TID %d called %s::unlock() while the lock is held by tid %d", mtid, getName(), tid);
+      xsink->raiseException("LOCK-ERROR", "TID %d called %s::unlock() while the lock is held by tid %d", mtid, getName(), t);
       return -1;
    }
    return 0;
 }
 
 int SmartMutex::tryGrabImpl(int mtid, VLock *nvl) {
-   if (tid != Lock_Unlocked)
-      return -1;
-   return 0;
+   int t;
+   return cas_grab(mtid, t) ? 0 : -1;
 }
 
 int SmartMutex::externWaitImpl(int mtid, QoreCondition *cond, ExceptionSink *xsink, int64 timeout_ms) {
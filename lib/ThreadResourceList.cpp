@@ -33,6 +33,7 @@
 #include <qore/Qore.h>
 #include "qore/intern/ThreadResourceList.h"
 #include <qore/AbstractThreadResource.h>
+#include "qore/intern/AbstractSmartLock.h"
 
 Sequence ThreadResourceList::seq;
 
@@ -60,9 +61,43 @@ void ThreadResourceList::set(const ResolvedCallReferenceNode* rcr, QoreValue arg
    crmap.insert(i, crmap_t::value_type(rcr->refRefSelf(), ArgPgm(arg.getReferencedValue(), pgm)));
 }
 
+void ThreadResourceList::setLock(AbstractSmartLock* asl) {
+   // ignore object if already set
+   if (asl->trl)
+      return;
+
+   asl->ref();
+   asl->trl = this;
+   asl->trl_prev = nullptr;
+   asl->trl_next = asl_head;
+   if (asl_head)
+      asl_head->trl_prev = asl;
+   asl_head = asl;
+}
+
+int ThreadResourceList::removeLock(AbstractSmartLock* asl) {
+   ThreadResourceList* l = asl->trl;
+   if (!l)
+      return -1;
+
+   if (asl->trl_prev)
+      asl->trl_prev->trl_next = asl->trl_next;
+   else
+      l->asl_head = asl->trl_next;
+   if (asl->trl_next)
+      asl->trl_next->trl_prev = asl->trl_prev;
+   asl->trl = nullptr;
+   asl->trl_prev = asl->trl_next = nullptr;
+   asl->deref();
+   return 0;
+}
+
 bool ThreadResourceList::check(AbstractThreadResource* atr) const {
    //printd(5, "TRL::check(atr: %p)\n", atr);
-   return trset.find(atr) != trset.end();
+   if (trset.find(atr) != trset.end())
+      return true;
+   AbstractSmartLock* asl = dynamic_cast<AbstractSmartLock*>(atr);
+   return asl && asl->trl == this;
 }
 
 void ThreadResourceList::purge(ExceptionSink* xsink) {
@@ -110,6 +145,20 @@ void ThreadResourceList::purge(ExceptionSink* xsink) {
 }
 
 void ThreadResourceList::purge(const QoreProgram* pgm, ExceptionSink* xsink) {
+   for (AbstractSmartLock* asl = asl_head; asl;) {
+      AbstractSmartLock* next = asl->trl_next;
+      if (!pgm || asl->getProgram() == pgm) {
+         // take over the list's reference and unlink the lock before running cleanup as in the loop below
+         asl->ref();
+         removeLock(asl);
+
+         asl->cleanup(xsink);
+         asl->deref();
+         // cleanup can only remove the current lock, so the next lock is still valid
+      }
+      asl = next;
+   }
+
    for (trset_t::iterator i = trset.begin(), e = trset.end(); i != e;) {
       AbstractThreadResource* atr = *i;
       if (!pgm || ((*i)->getProgram() == pgm)) {
@@ -149,7 +149,8 @@ int VLock::waitOn(AbstractSmartLock *asl, VLock *vl, ExceptionSink *xsink, int t
    waiting_on = asl;
 
    int rc = 0;
-   AbstractSmartLock *vl_wait = vl->waiting_on;
+   // vl is not yet set if the lock has just been acquired without asl_lock; the owner will detect any deadlock in this case
+   AbstractSmartLock *vl_wait = vl ? vl->waiting_on : 0;
    //printd(5, "VLock::waitOn(asl=%p) vl_wait=%p other_tid=%d\n", asl, vl_wait, vl->tid);
    if (vl_wait && find(vl_wait)) {
       // NOTE: we throw an exception here anyway as a deadlock is a programming mistake and therefore should be visible to the programmer
@@ -176,7 +177,8 @@ int VLock::waitOn(AbstractSmartLock *asl, QoreCondition *cond, VLock *vl, Except
    waiting_on = asl;
 
    int rc = 0;
-   AbstractSmartLock *vl_wait = vl->waiting_on;
+   // vl is not yet set if the lock has just been acquired without asl_lock; the owner will detect any deadlock in this case
+   AbstractSmartLock *vl_wait = vl ? vl->waiting_on : 0;
    //printd(5, "VLock::waitOn(asl=%p) vl_wait=%p other_tid=%d\n", asl, vl_wait, vl->tid);
    if (vl_wait && find(vl_wait)) {
       // NOTE: we throw an exception here anyway as a deadlock is a programming mistake and therefore should be visible to the programmer
@@ -39,61 +39,104 @@ VRMutex::VRMutex() : count(0) {
 int VRMutex::enter(ExceptionSink *xsink) {
    int mtid = gettid();
    VLock *nvl = getVLock();
+
+   int rc;
+   if (VRMutex::grabFastImpl(mtid, rc)) {
+      if (!rc)
+         mark_and_push(mtid, nvl);
+      return rc;
+   }
+
    AutoLocker al(&asl_lock);
-   int rc = VRMutex::grabImpl(mtid, nvl, xsink);
+   rc = VRMutex::grabImpl(mtid, nvl, xsink);
    if (!rc)
       mark_and_push(mtid, nvl);
    return rc;
 }
 
 int VRMutex::exit() {
-   AutoLocker al(&asl_lock);
-   int rc = VRMutex::releaseImpl();
-   if (!rc)
-      release_and_signal();
-   return rc;
+   assert(tid == gettid());
+   assert(count);
+   if (--count)
+      return -1;
+   release_fast(tid);
+   return 0;
+}
+
+bool VRMutex::grabFastImpl(int mtid, int& rc) {
+   // only the owner can set tid to its own TID, and only the owner modifies count
+   if (tid != mtid) {
+      int t;
+      if (!cas_grab(mtid, t))
+         return false;
+   }
+   printd(5, "VRMutex::enter() this=%p count: %d->%d\n", this, count.load(), count + 1);
+   rc = count++;
+   return true;
+}
+
+bool VRMutex::releaseFastImpl(int mtid, int& rc) {
+   if (tid != mtid)
+      return false;
+   // count must be > 0 because tid > 0
+   assert(count);
+   printd(5, "VRMutex::exit() this=%p count: %d->%d\n", this, count.load(), count - 1);
+   if (--count) {
+      rc = -1;
+      return true;
+   }
+   release_fast(mtid);
+   rc = 0;
+   return true;
 }
 
 void VRMutex::cleanupImpl() {
    if (tid == gettid()) {
-      release_and_signal();
+      // reset the count before releasing the lock, as it can be acquired immediately by another thread
       count = 0;
+      release_and_signal();
    }
 }
 
 int VRMutex::grabImpl(int mtid, VLock *nvl, ExceptionSink *xsink, int64 timeout_ms) {
    if (tid != mtid) {
-      while (tid != Lock_Unlocked) {
-	 if (tid == Lock_Deleted) {
+      int t;
+      while (!cas_grab(mtid, t)) {
+	 if (t == Lock_Deleted) {
 	    xsink->raiseException("LOCK-ERROR", "TID %d cannot execute %s::enter() because the object has been deleted in another thread", mtid, getName());
 	    return -1;
 	 }
 
 	 ++waiting;
-	 int rc = nvl->waitOn((AbstractSmartLock *)this, vl, xsink, timeout_ms);
+	 // the lock can be released without asl_lock, so check again after incrementing the waiting count
+	 int rc = tid == Lock_Unlocked ? 0 : nvl->waitOn((AbstractSmartLock *)this, vl, xsink, timeout_ms);
 	 --waiting;
 	 // if rc is non-zero there was a timeout or deadlock
 	 if (rc)
 	    return -1;
       }
-      // the thread lock list must always be the same if the lock was grabbed
-      assert((mtid == tid  && vl == nvl) || (tid == Lock_Unlocked && !vl));
+      // the previous owner clears its thread lock list before releasing the lock
+      assert(!vl);
    }
-   printd(5, "VRMutex::enter() this=%p count: %d->%d\n", this, count, count + 1);
+   else
+      // the thread lock list must always be the same if the lock was grabbed
+      assert(vl == nvl);
+   printd(5, "VRMutex::enter() this=%p count: %d->%d\n", this, count.load(), count + 1);
 
    return count++;
 }
 
 int VRMutex::tryGrabImpl(int mtid, VLock *nvl) {
    if (tid != mtid) {
-      if (tid != Lock_Unlocked)
+      int t;
+      if (!cas_grab(mtid, t))
 	 return -1;
 
-      // the thread lock list must always be the same if the lock was grabbed
-      assert((mtid == tid  && vl == nvl) || (tid == Lock_Unlocked && !vl));
+      // the previous owner clears its thread lock list before releasing the lock
+      assert(!vl);
    }
 
-   printd(5, "VRMutex::enter() this=%p count: %d->%d\n", this, count, count + 1);
+   printd(5, "VRMutex::enter() this=%p count: %d->%d\n", this, count.load(), count + 1);
 
    return count++;
 }
@@ -101,7 +144,7 @@ int VRMutex::tryGrabImpl(int mtid, VLock *nvl) {
 // internal use only
 int VRMutex::releaseImpl() {
    assert(tid == gettid());
-   printd(5, "VRMutex::exit() this=%p count: %d->%d\n", this, count, count - 1);
+   printd(5, "VRMutex::exit() this=%p count: %d->%d\n", this, count.load(), count - 1);
 
    --count;
    // if this is the last thread from the group to exit the lock, then return 0
@@ -110,24 +153,25 @@ int VRMutex::releaseImpl() {
 
 int VRMutex::releaseImpl(ExceptionSink *xsink) {
    int mtid = gettid();
-   if (tid == Lock_Unlocked) {
+   int t = tid;
+   if (t == Lock_Unlocked) {
       // use getName() here so it can be safely inherited
       xsink->raiseException("LOCK-ERROR", "TID %d called %s::exit() without acquiring the lock", mtid, getName());
       return -1;
    }
-   if (tid == Lock_Deleted) {
+   if (t == Lock_Deleted) {
       xsink->raiseException("LOCK-ERROR", "TID %d cannot execute %s::exit() because the object has been deleted in another thread", mtid, getName());
       return -1;
    }
-   if (tid != mtid) {
+   if (t != mtid) {
       // use getName() here so it can be safely inherited
-      xsink->raiseException("LOCK-ERROR", "TID %d called %s::exit() while the lock is held by TID %d", mtid, getName(), tid);
+      xsink->raiseException("LOCK-ERROR", "TID %d called %s::exit() while the lock is held by TID %d", mtid, getName(), t);
       return -1;
    }
    // count must be > 0 because tid > 0
    assert(count);
 
-   printd(5, "VRMutex::exit() this=%p count: %d->%d\n", this, count, count - 1);
+   printd(5, "VRMutex::exit() this=%p count: %d->%d\n", this, count.load(), count - 1);
 
    --count;
    // if this is the last thread from the group to exit the lock, then return 0
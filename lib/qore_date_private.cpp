@@ -31,11 +31,14 @@
 
 #include <qore/Qore.h>
 #include "qore/intern/qore_date_private.h"
+#include "qore/intern/QoreDateFormat.h"
 
 #include <sys/time.h>
 #include <errno.h>
 #include <string.h>
 
+#include <map>
+
 const char *STATIC_UTC = "UTC";
 
 const int qore_date_info::month_lengths[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
@@ -699,25 +702,137 @@ void qore_date_private::format(QoreString &str, const char *fmt) const {
    qore_time_info i;
    get(i);
 
-   const char *s = fmt;
+   QoreDateFormat::get(fmt, strlen(fmt)).format(str, i);
+}
+
+// output operation codes
+enum qore_date_format_op_e {
+   QDF_LITERAL,
+   QDF_ISO_DATE,         // YYYY-MM-DD
+   QDF_ISO_TIME,         // HH:mm:SS
+   QDF_YEAR4,            // YYYY
+   QDF_YEAR2,            // YY
+   QDF_MONTH2,           // MM
+   QDF_MONTH,            // M
+   QDF_MONTH_NAME,       // Month
+   QDF_MONTH_ABBR,       // Mon
+   QDF_MONTH_NAME_UPPER, // MONTH
+   QDF_MONTH_ABBR_UPPER, // MON
+   QDF_DAY2,             // DD
+   QDF_DAY,              // D
+   QDF_DOW_NAME,         // Day
+   QDF_DOW_NAME_UPPER,   // DAY
+   QDF_DOW_ABBR,         // Dy
+   QDF_DOW_ABBR_UPPER,   // DY
+   QDF_HOUR2,            // HH
+   QDF_HOUR,             // H
+   QDF_HOUR12_2,         // hh
+   QDF_HOUR12,           // h
+   QDF_AMPM_UPPER,       // P
+   QDF_AMPM_LOWER,       // p
+   QDF_MINUTE2,          // mm
+   QDF_MINUTE,           // m
+   QDF_SECOND2,          // SS
+   QDF_SECOND,           // S
+   QDF_MS3,              // ms, uu
+   QDF_MS,               // u
+   QDF_US6,              // us, xx
+   QDF_US,               // x
+   QDF_US_TRIM,          // y
+   QDF_ZONE_NAME,        // z
+   QDF_ZONE_OFFSET,      // Z
+};
+
+// input operation codes
+enum qore_date_parse_op_e {
+   QDP_SKIP,
+   QDP_YEAR_ERR,
+   QDP_YEAR4,
+   QDP_YEAR2,
+   QDP_MONTH2,
+   QDP_MONTH_ABBR,
+   QDP_MONTH_NONE,
+   QDP_MINUTE2,
+   QDP_MS,
+   QDP_MINUTE_NONE,
+   QDP_DAY2,
+   QDP_DAY_NONE,
+   QDP_HOUR2,
+   QDP_HOUR_NONE,
+   QDP_SUBSEC3,
+   QDP_SUBSEC6,
+   QDP_SECOND2,
+   QDP_SECOND_NONE,
+   QDP_US,
+};
+
+// appends a non-negative integer zero-padded to the given width
+static void concat_int(QoreString& str, int v, int width = 1) {
+   if (v < 0) {
+      str.sprintf("%0*d", width, v);
+      return;
+   }
+
+   char buf[16];
+   char* p = buf + sizeof(buf);
+   do {
+      *--p = '0' + (v % 10);
+      v /= 10;
+      --width;
+   } while (v);
+   while (width-- > 0)
+      *--p = '0';
+   str.concat(p, buf + sizeof(buf) - p);
+}
+
+QoreDateFormat::QoreDateFormat(const char* n_mask, size_t len) : mask(n_mask, len) {
+   compileFormat();
+   compileParse();
+}
+
+void QoreDateFormat::compileFormat() {
+   const char* start = mask.c_str();
+   const char* s = start;
+
+   // adds a literal for the character at the current position, merging with a preceding literal if possible
+   auto add_literal = [&] () {
+      unsigned off = s - start;
+      if (!fops.empty() && fops.back().code == QDF_LITERAL && fops.back().off + fops.back().len == off)
+         ++fops.back().len;
+      else
+         fops.push_back(op_t(QDF_LITERAL, off, 1));
+   };
+
    while (*s) {
+      // specialized ISO-8601 date and time components
+      if (!strncmp(s, "YYYY-MM-DD", 10)) {
+         fops.push_back(op_t(QDF_ISO_DATE));
+         s += 10;
+         continue;
+      }
+      if (!strncmp(s, "HH:mm:SS", 8)) {
+         fops.push_back(op_t(QDF_ISO_TIME));
+         s += 8;
+         continue;
+      }
+
       switch (*s) {
          case 'Y':
             if (s[1] != 'Y') {
-               str.concat('Y');
+               add_literal();
                break;
             }
             s++;
             if ((s[1] == 'Y') && (s[2] == 'Y')) {
-               str.sprintf("%04d", i.year);
+               fops.push_back(op_t(QDF_YEAR4));
                s += 2;
             }
             else
-               str.sprintf("%02d", i.year - (i.year / 100) * 100);
+               fops.push_back(op_t(QDF_YEAR2));
             break;
          case 'M':
             if (s[1] == 'M') {
-               str.sprintf("%02d", i.month);
+               fops.push_back(op_t(QDF_MONTH2));
                s++;
                break;
             }
@@ -725,151 +840,630 @@ void qore_date_private::format(QoreString &str, const char *fmt) const {
                s += 2;
                if ((s[1] == 't') && (s[2] == 'h')) {
                   s += 2;
-                  if (i.month && (i.month <= 12))
-                     str.sprintf("%s", months[(int)i.month - 1].long_name);
-                  else
-                     str.sprintf("Month%d", i.month - 1);
+                  fops.push_back(op_t(QDF_MONTH_NAME));
                   break;
                }
-               if (i.month && (i.month <= 12))
-                  str.sprintf("%s", months[(int)i.month - 1].abbr);
-               else
-                  str.sprintf("M%02d", i.month);
+               fops.push_back(op_t(QDF_MONTH_ABBR));
                break;
             }
             if ((s[1] == 'O') && (s[2] == 'N')) {
                s += 2;
                if ((s[1] == 'T') && (s[2] == 'H')) {
                   s += 2;
-                  if (i.month && (i.month <= 12)) {
-                     str.sprintf("%s", months[(int)i.month - 1].upper_long_name);
-                  }
-                  else
-                     str.sprintf("MONTH%d", i.month);
+                  fops.push_back(op_t(QDF_MONTH_NAME_UPPER));
                   break;
                }
-               if (i.month && (i.month <= 12)) {
-                  str.sprintf("%s", months[(int)i.month - 1].upper_abbr);
-               }
-               else
-                  str.sprintf("M%02d", i.month);
+               fops.push_back(op_t(QDF_MONTH_ABBR_UPPER));
                break;
             }
-            str.sprintf("%d", i.month);
+            fops.push_back(op_t(QDF_MONTH));
             break;
          case 'D':
             if (s[1] == 'D') {
-               str.sprintf("%02d", i.day);
+               fops.push_back(op_t(QDF_DAY2));
                s++;
                break;
             }
             if ((s[1] == 'a') && (s[2] == 'y')) {
                s += 2;
-               int wday = qore_date_info::getDayOfWeek(i.year, i.month, i.day);
-               str.sprintf("%s", days[wday].long_name);
+               fops.push_back(op_t(QDF_DOW_NAME));
                break;
             }
             if ((s[1] == 'A') && (s[2] == 'Y')) {
                s += 2;
-               int wday = qore_date_info::getDayOfWeek(i.year, i.month, i.day);
-               str.sprintf("%s", days[wday].upper_long_name);
+               fops.push_back(op_t(QDF_DOW_NAME_UPPER));
                break;
             }
             if ((s[1] == 'y') || (s[1] == 'Y')) {
                s++;
-               int wday = qore_date_info::getDayOfWeek(i.year, i.month, i.day);
-               str.sprintf("%s", *s == 'Y' ? days[wday].upper_abbr : days[wday].abbr);
+               fops.push_back(op_t(*s == 'Y' ? QDF_DOW_ABBR_UPPER : QDF_DOW_ABBR));
                break;
             }
-            str.sprintf("%d", i.day);
+            fops.push_back(op_t(QDF_DAY));
             break;
          case 'H':
             if (s[1] == 'H') {
-               str.sprintf("%02d", i.hour);
+               fops.push_back(op_t(QDF_HOUR2));
                s++;
             }
             else
-               str.sprintf("%d", i.hour);
+               fops.push_back(op_t(QDF_HOUR));
             break;
          case 'h':
             if (s[1] == 'h') {
-               str.sprintf("%02d", ampm(i.hour));
+               fops.push_back(op_t(QDF_HOUR12_2));
                s++;
             }
             else
-               str.sprintf("%d", ampm(i.hour));
+               fops.push_back(op_t(QDF_HOUR12));
             break;
          case 'P':
-            if (i.hour > 11)
-               str.sprintf("PM");
-            else
-               str.sprintf("AM");
+            fops.push_back(op_t(QDF_AMPM_UPPER));
             break;
          case 'p':
-            if (i.hour > 11)
-               str.sprintf("pm");
-            else
-               str.sprintf("am");
+            fops.push_back(op_t(QDF_AMPM_LOWER));
             break;
          case 'm':
             if (s[1] == 'm') {
-               str.sprintf("%02d", i.minute);
+               fops.push_back(op_t(QDF_MINUTE2));
                s++;
             }
             else if (s[1] == 's') {
-               str.sprintf("%03d", i.us / 1000);
+               fops.push_back(op_t(QDF_MS3));
                s++;
             }
             else
-               str.sprintf("%d", i.minute);
+               fops.push_back(op_t(QDF_MINUTE));
             break;
          case 'S':
             if (s[1] == 'S') {
-               str.sprintf("%02d", i.second);
+               fops.push_back(op_t(QDF_SECOND2));
                s++;
             }
             else
-               str.sprintf("%d", i.second);
+               fops.push_back(op_t(QDF_SECOND));
             break;
          case 'u':
             if (s[1] == 'u') {
-               str.sprintf("%03d", i.us / 1000);
+               fops.push_back(op_t(QDF_MS3));
                s++;
             }
             else if (s[1] == 's') {
-               str.sprintf("%06d", i.us);
+               fops.push_back(op_t(QDF_US6));
                s++;
             }
             else
-               str.sprintf("%d", i.us / 1000);
+               fops.push_back(op_t(QDF_MS));
             break;
          case 'x':
             if (s[1] == 'x') {
-               str.sprintf("%06d", i.us);
+               fops.push_back(op_t(QDF_US6));
                s++;
             }
             else
-               str.sprintf("%d", i.us);
+               fops.push_back(op_t(QDF_US));
             break;
          case 'y':
-            str.sprintf("%06d", i.us);
-            str.trim_trailing('0');
+            fops.push_back(op_t(QDF_US_TRIM));
             break;
          case 'z':
-	    str.sprintf("%s", i.zname);
+            fops.push_back(op_t(QDF_ZONE_NAME));
+            break;
+            // add iso8601 UTC offset
+         case 'Z':
+            fops.push_back(op_t(QDF_ZONE_OFFSET));
             break;
-	    // add iso8601 UTC offset
-	 case 'Z':
-	    concatOffset(i.utcoffset, str);
-	    break;
          default:
-	    str.concat(*s);
+            add_literal();
             break;
       }
       s++;
    }
 }
 
+void QoreDateFormat::compileParse() {
+   const char* s = mask.c_str();
+
+   // adds an operation skipping input bytes, merging with a preceding skip operation if possible
+   auto add_skip = [&] () {
+      if (!pops.empty() && pops.back().code == QDP_SKIP)
+         ++pops.back().len;
+      else
+         pops.push_back(op_t(QDP_SKIP, 0, 1));
+   };
+
+   // the len member gives the number of input bytes consumed by each operation
+   while (*s) {
+      switch (*s) {
+         case 'Y':
+            if (s[1] != 'Y') {
+               pops.push_back(op_t(QDP_YEAR_ERR));
+               // parsing always stops here
+               return;
+            }
+            if (s[2] == 'Y' && s[3] == 'Y') {
+               pops.push_back(op_t(QDP_YEAR4, 0, 4));
+               s += 3;
+            }
+            else {
+               pops.push_back(op_t(QDP_YEAR2, 0, 2));
+               ++s;
+            }
+            break;
+
+         case 'M':
+            if (s[1] == 'M') {
+               pops.push_back(op_t(QDP_MONTH2, 0, 2));
+               s++;
+               break;
+            }
+            // 'M' is not supported because there is no clear way how to get eg. 1 or 11
+            if ((s[1] == 'o' || s[1] == 'O') && (s[2] == 'n' || s[2] == 'N')) {
+               pops.push_back(op_t(QDP_MONTH_ABBR, 0, 3));
+               s += 2;
+               break;
+            }
+            pops.push_back(op_t(QDP_MONTH_NONE, 0, 1));
+            break;
+
+         case 'm':
+            if (s[1] == 'm') {
+               pops.push_back(op_t(QDP_MINUTE2, 0, 2));
+               s++;
+               break;
+            }
+            if (s[1] == 's') {
+               pops.push_back(op_t(QDP_MS, 0, 3));
+               ++s;
+               break;
+            }
+            pops.push_back(op_t(QDP_MINUTE_NONE, 0, 1));
+            break;
+
+         case 'D':
+         case 'd':
+            if (s[1] == 'D' || s[1] == 'd') {
+               pops.push_back(op_t(QDP_DAY2, 0, 2));
+               s++;
+            }
+            else
+               pops.push_back(op_t(QDP_DAY_NONE, 0, 1));
+            break;
+
+         case 'H':
+         case 'h':
+            if (s[1] == 'H' || s[1] == 'h') {
+               pops.push_back(op_t(QDP_HOUR2, 0, 2));
+               s++;
+            }
+            else
+               pops.push_back(op_t(QDP_HOUR_NONE, 0, 1));
+            break;
+
+         case 's':
+            if (s[1] == 's' && s[2] == 's') {
+               if (s[3] == 's' && s[4] == 's' && s[5] == 's') {
+                  pops.push_back(op_t(QDP_SUBSEC6, 0, 6));
+                  s += 5;
+               }
+               else {
+                  pops.push_back(op_t(QDP_SUBSEC3, 0, 3));
+                  s += 2;
+               }
+            }
+            else
+               add_skip();
+            break;
+
+         case 'S':
+            if (s[1] == 'S') {
+               pops.push_back(op_t(QDP_SECOND2, 0, 2));
+               s++;
+            }
+            else
+               pops.push_back(op_t(QDP_SECOND_NONE, 0, 1));
+            break;
+
+         case 'u':
+            if (s[1] == 's') {
+               pops.push_back(op_t(QDP_US, 0, 6));
+               ++s;
+            }
+            else
+               add_skip();
+            break;
+
+         default:
+            add_skip();
+            break;
+      }
+      s++;
+   }
+}
+
+void QoreDateFormat::format(QoreString& str, const qore_time_info& i) const {
+   for (auto& op : fops) {
+      switch (op.code) {
+         case QDF_LITERAL:
+            str.concat(mask.c_str() + op.off, op.len);
+            break;
+         case QDF_ISO_DATE:
+            concat_int(str, i.year, 4);
+            str.concat('-');
+            concat_int(str, i.month, 2);
+            str.concat('-');
+            concat_int(str, i.day, 2);
+            break;
+         case QDF_ISO_TIME:
+            concat_int(str, i.hour, 2);
+            str.concat(':');
+            concat_int(str, i.minute, 2);
+            str.concat(':');
+            concat_int(str, i.second, 2);
+            break;
+         case QDF_YEAR4:
+            concat_int(str, i.year, 4);
+            break;
+         case QDF_YEAR2:
+            concat_int(str, i.year - (i.year / 100) * 100, 2);
+            break;
+         case QDF_MONTH2:
+            concat_int(str, i.month, 2);
+            break;
+         case QDF_MONTH:
+            concat_int(str, i.month);
+            break;
+         case QDF_MONTH_NAME:
+            if (i.month && (i.month <= 12))
+               str.concat(months[(int)i.month - 1].long_name);
+            else
+               str.sprintf("Month%d", i.month - 1);
+            break;
+         case QDF_MONTH_ABBR:
+            if (i.month && (i.month <= 12))
+               str.concat(months[(int)i.month - 1].abbr);
+            else
+               str.sprintf("M%02d", i.month);
+            break;
+         case QDF_MONTH_NAME_UPPER:
+            if (i.month && (i.month <= 12))
+               str.concat(months[(int)i.month - 1].upper_long_name);
+            else
+               str.sprintf("MONTH%d", i.month);
+            break;
+         case QDF_MONTH_ABBR_UPPER:
+            if (i.month && (i.month <= 12))
+               str.concat(months[(int)i.month - 1].upper_abbr);
+            else
+               str.sprintf("M%02d", i.month);
+            break;
+         case QDF_DAY2:
+            concat_int(str, i.day, 2);
+            break;
+         case QDF_DAY:
+            concat_int(str, i.day);
+            break;
+         case QDF_DOW_NAME:
+            str.concat(days[qore_date_info::getDayOfWeek(i.year, i.month, i.day)].long_name);
+            break;
+         case QDF_DOW_NAME_UPPER:
+            str.concat(days[qore_date_info::getDayOfWeek(i.year, i.month, i.day)].upper_long_name);
+            break;
+         case QDF_DOW_ABBR:
+            str.concat(days[qore_date_info::getDayOfWeek(i.year, i.month, i.day)].abbr);
+            break;
+         case QDF_DOW_ABBR_UPPER:
+            str.concat(days[qore_date_info::getDayOfWeek(i.year, i.month, i.day)].upper_abbr);
+            break;
+         case QDF_HOUR2:
+            concat_int(str, i.hour, 2);
+            break;
+         case QDF_HOUR:
+            concat_int(str, i.hour);
+            break;
+         case QDF_HOUR12_2:
+            concat_int(str, ampm(i.hour), 2);
+            break;
+         case QDF_HOUR12:
+            concat_int(str, ampm(i.hour));
+            break;
+         case QDF_AMPM_UPPER:
+            str.concat(i.hour > 11 ? "PM" : "AM");
+            break;
+         case QDF_AMPM_LOWER:
+            str.concat(i.hour > 11 ? "pm" : "am");
+            break;
+         case QDF_MINUTE2:
+            concat_int(str, i.minute, 2);
+            break;
+         case QDF_MINUTE:
+            concat_int(str, i.minute);
+            break;
+         case QDF_SECOND2:
+            concat_int(str, i.second, 2);
+            break;
+         case QDF_SECOND:
+            concat_int(str, i.second);
+            break;
+         case QDF_MS3:
+            concat_int(str, i.us / 1000, 3);
+            break;
+         case QDF_MS:
+            concat_int(str, i.us / 1000);
+            break;
+         case QDF_US6:
+            concat_int(str, i.us, 6);
+            break;
+         case QDF_US:
+            concat_int(str, i.us);
+            break;
+         case QDF_US_TRIM:
+            concat_int(str, i.us, 6);
+            str.trim_trailing('0');
+            break;
+         case QDF_ZONE_NAME:
+            str.concat(i.zname);
+            break;
+         case QDF_ZONE_OFFSET:
+            concatOffset(i.utcoffset, str);
+            break;
+         default:
+            assert(false);
+            break;
+      }
+   }
+}
+
+void QoreDateFormat::format(QoreString& str, const DateTime& dt) const {
+   qore_time_info i;
+   dt.priv->get(i);
+   format(str, i);
+}
+
+static int qd_get_digit(unsigned& rv, const char*& p, unsigned factor) {
+   if (*p < '0' || *p > '9')
+      return -1;
+
+   rv += (*p - '0') * factor;
+   ++p;
+   return 0;
+}
+
+// returns 0 if invalid data is encountered
+static unsigned parse_int_2(const char *p) {
+   unsigned rv = 0;
+   if (qd_get_digit(rv, p, 10))
+      return 0;
+   if (qd_get_digit(rv, p, 1))
+      return 0;
+   return rv;
+}
+
+// returns 0 if invalid data is encountered
+static unsigned parse_int_3(const char *p) {
+   unsigned rv = 0;
+   if (qd_get_digit(rv, p, 100))
+      return 0;
+   if (qd_get_digit(rv, p, 10))
+      return 0;
+   if (qd_get_digit(rv, p, 1))
+      return 0;
+   return rv;
+}
+
+// returns 0 if invalid data is encountered
+static unsigned parse_int_4(const char *p) {
+   unsigned rv = 0;
+   if (qd_get_digit(rv, p, 1000))
+      return 0;
+   if (qd_get_digit(rv, p, 100))
+      return 0;
+   if (qd_get_digit(rv, p, 10))
+      return 0;
+   if (qd_get_digit(rv, p, 1))
+      return 0;
+   return rv;
+}
+
+// returns 0 if invalid data is encountered
+static unsigned parse_int_6(const char *p) {
+   unsigned rv = 0;
+   if (qd_get_digit(rv, p, 100000))
+      return 0;
+   if (qd_get_digit(rv, p, 10000))
+      return 0;
+   if (qd_get_digit(rv, p, 1000))
+      return 0;
+   if (qd_get_digit(rv, p, 100))
+      return 0;
+   if (qd_get_digit(rv, p, 10))
+      return 0;
+   if (qd_get_digit(rv, p, 1))
+      return 0;
+   return rv;
+}
+
+DateTimeNode* QoreDateFormat::parse(const QoreString& dtstr, const AbstractQoreZoneInfo* tz, ExceptionSink* xsink) const {
+   qore_tm dt;
+   dt.clear();
+   dt.month = 1;
+   dt.day = 1;
+
+   const char* d = dtstr.getBuffer();
+   const char* de = d + dtstr.strlen();
+
+   for (auto& op : pops) {
+      const char* err = nullptr;
+      switch (op.code) {
+         case QDP_SKIP:
+            break;
+
+         case QDP_YEAR_ERR:
+            xsink->raiseException("INVALID-DATE", "'Y' has to be used as 'YY' or 'YYYY'");
+            return nullptr;
+
+         case QDP_YEAR4:
+            if (d >= de) {
+               err = "year";
+               break;
+            }
+            dt.year = parse_int_4(d);
+            break;
+
+         case QDP_YEAR2:
+            if (d >= de) {
+               err = "year";
+               break;
+            }
+            // obtain the current century
+            {
+               DateTime tmpdt(q_epoch());
+               dt.year = parse_int_2(d) + (tmpdt.getYear() / 100 * 100);
+            }
+            break;
+
+         case QDP_MONTH2:
+         case QDP_MONTH_ABBR:
+         case QDP_MONTH_NONE:
+            if (d >= de) {
+               err = "month";
+               break;
+            }
+            if (op.code == QDP_MONTH2)
+               dt.month = parse_int_2(d);
+            else if (op.code == QDP_MONTH_ABBR) {
+               QoreString str(d, 3);
+               dt.month = str.strlen() == 3 ? qore_date_info::getMonthIxFromAbbr(str.getBuffer()) : -1;
+               if (dt.month < 0 || dt.month > 11) {
+                  xsink->raiseException("INVALID-DATE", "Invalid 'Mon' string: '%s'", !str.empty() ? str.getBuffer() : "<none>");
+                  return nullptr;
+               }
+               ++dt.month;
+            }
+            break;
+
+         case QDP_MINUTE2:
+         case QDP_MS:
+         case QDP_MINUTE_NONE:
+            if (d >= de) {
+               err = "minute";
+               break;
+            }
+            if (op.code == QDP_MINUTE2)
+               dt.minute = parse_int_2(d);
+            else if (op.code == QDP_MS)
+               dt.us = parse_int_3(d) * 1000;
+            break;
+
+         case QDP_DAY2:
+         case QDP_DAY_NONE:
+            if (d >= de) {
+               err = "day";
+               break;
+            }
+            if (op.code == QDP_DAY2)
+               dt.day = parse_int_2(d);
+            break;
+
+         case QDP_HOUR2:
+         case QDP_HOUR_NONE:
+            if (d >= de) {
+               err = "hour";
+               break;
+            }
+            if (op.code == QDP_HOUR2)
+               dt.hour = parse_int_2(d);
+            break;
+
+         case QDP_SUBSEC3:
+         case QDP_SUBSEC6:
+            if (d >= de) {
+               err = "sub-second";
+               break;
+            }
+            dt.us = op.code == QDP_SUBSEC6 ? parse_int_6(d) : parse_int_3(d) * 1000;
+            break;
+
+         case QDP_SECOND2:
+         case QDP_SECOND_NONE:
+            if (d >= de) {
+               err = "second";
+               break;
+            }
+            if (op.code == QDP_SECOND2)
+               dt.second = parse_int_2(d);
+            break;
+
+         case QDP_US:
+            if (d >= de) {
+               err = "microsecond";
+               break;
+            }
+            dt.us = parse_int_6(d);
+            break;
+
+         default:
+            assert(false);
+            break;
+      }
+      if (err) {
+         xsink->raiseException("INVALID-DATE", "no more input to process for %s mask", err);
+         return nullptr;
+      }
+      d += op.len;
+   }
+
+   SimpleRefHolder<DateTimeNode> rv(DateTimeNode::makeAbsolute(tz, dt.year, dt.month, dt.day, dt.hour, dt.minute, dt.second, dt.us, xsink));
+   return *xsink ? nullptr : rv.release();
+}
+
+// per-thread cache of compiled date formats
+class QoreDateFormatCache {
+public:
+   DLLLOCAL ~QoreDateFormatCache() {
+      clear();
+   }
+
+   DLLLOCAL const QoreDateFormat& get(const char* mask, size_t len) {
+      std::string key(mask, len);
+      fmap_t::iterator i = fmap.lower_bound(key);
+      if (i != fmap.end() && i->first == key)
+         return *i->second;
+
+      // formats are normally taken from a small set of constant strings; limit the cache size in case they are not
+      if (fmap.size() >= QDF_CACHE_MAX) {
+         clear();
+         i = fmap.end();
+      }
+
+      QoreDateFormat* f = new QoreDateFormat(mask, len);
+      fmap.insert(i, fmap_t::value_type(key, f));
+      return *f;
+   }
+
+   DLLLOCAL void clear() {
+      for (auto& i : fmap)
+         delete i.second;
+      fmap.clear();
+   }
+
+protected:
+   typedef std::map<std::string, QoreDateFormat*> fmap_t;
+   enum { QDF_CACHE_MAX = 64 };
+
+   fmap_t fmap;
+};
+
+static thread_local QoreDateFormatCache date_format_cache;
+
+const QoreDateFormat& QoreDateFormat::get(const char* mask, size_t len) {
+   return date_format_cache.get(mask, len);
+}
+
+void QoreDateFormat::clearThreadCache() {
+   date_format_cache.clear();
+}
+
 void qore_relative_time::setIso8601(const char* str) {
    const char *p = str;
    if (*p == 'P' || *p == 'p')
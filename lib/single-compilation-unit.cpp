@@ -146,6 +146,11 @@
 #include "QoreSSLBase.cpp"
 #include "QoreSSLCertificate.cpp"
 #include "QoreSSLPrivateKey.cpp"
+#include "QoreSSLContext.cpp"
+#include "QoreHttpConnectionPool.cpp"
+#include "QoreDnsCache.cpp"
+#include "QoreSocketPollSet.cpp"
+#include "QoreWebSocket.cpp"
 #include "QoreSocketObject.cpp"
 #include "QoreCondition.cpp"
 #include "QoreQueue.cpp"
@@ -153,6 +158,7 @@
 #include "QoreRegex.cpp"
 #include "QoreRegexBase.cpp"
 #include "QoreRegexSubst.cpp"
+#include "CsvRecordBuilder.cpp"
 #include "QoreTransliteration.cpp"
 #include "Sequence.cpp"
 #include "QoreReferenceCounter.cpp"
@@ -317,7 +323,10 @@
 #include "QC_Counter.cpp"
 #include "QC_SSLCertificate.cpp"
 #include "QC_SSLPrivateKey.cpp"
+#include "QC_SSLContext.cpp"
 #include "QC_HTTPClient.cpp"
+#include "QC_HTTPConnectionPool.cpp"
+#include "QC_SocketPollSet.cpp"
 #include "QC_AutoLock.cpp"
 #include "QC_AutoGate.cpp"
 #include "QC_AutoReadLock.cpp"
@@ -326,6 +335,9 @@
 #include "QC_AbstractSmartLock.cpp"
 #include "QC_TimeZone.cpp"
 #include "QC_TreeMap.cpp"
+#include "QC_CsvRecordBuilder.cpp"
+#include "QC_DateFormat.cpp"
+#include "QC_StringBuilder.cpp"
 #include "QC_AbstractThreadResource.cpp"
 #include "QC_InputStream.cpp"
 #include "QC_BinaryInputStream.cpp"
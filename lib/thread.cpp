@@ -40,6 +40,7 @@
 #include "qore/intern/qore_program_private.h"
 #include "qore/intern/ModuleInfo.h"
 #include "qore/intern/QoreHashNodeIntern.h"
+#include "qore/intern/QoreDateFormat.h"
 
 // to register object types
 #include "qore/intern/QC_Queue.h"
@@ -62,6 +63,7 @@
 
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <set>
 #include <string>
 
@@ -92,6 +94,12 @@ size_t qore_thread_stack_limit = 0;
 // default thread creation attribute
 QorePThreadAttr ta_default;
 
+// cache of idle native threads
+QoreNativeThreadCache thread_cache;
+
+// built-in sampling profiler
+QoreSamplingProfiler qore_profiler;
+
 DLLLOCAL QoreThreadList thread_list;
 
 DLLLOCAL QoreClass* initThreadPoolClass(QoreNamespace& ns);
@@ -269,6 +277,12 @@ public:
    // current function/method name
    const char* current_code = nullptr;
 
+   // current code context, used by the sampling profiler to walk the call stack
+   const CodeContextHelperBase* current_ctx = nullptr;
+
+   // the profiler tick when the last profiling sample was taken in this thread
+   int64 profile_tick = 0;
+
    // current object context
    QoreObject* current_obj = nullptr;
 
@@ -434,7 +448,36 @@ public:
    }
 };
 
-static QoreThreadLocalStorage<ThreadData> thread_data;
+// use the initial-exec TLS model where supported so that accessing the current thread's data does not
+// require a function call
+#if defined(__GNUC__) && !defined(_Q_WINDOWS)
+#define QORE_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define QORE_TLS_MODEL
+#endif
+
+static thread_local ThreadData* current_thread_data QORE_TLS_MODEL = nullptr;
+
+// provides access to the current thread's ThreadData
+class QoreThreadDataStorage {
+public:
+   DLLLOCAL ThreadData* get() const {
+      return current_thread_data;
+   }
+
+   DLLLOCAL void set(ThreadData* td) {
+      current_thread_data = td;
+   }
+};
+
+static QoreThreadDataStorage thread_data;
+
+// resets thread-local caches when a native thread starts running a new Qore thread
+static void reset_thread_local_caches() {
+   thread_data.set(nullptr);
+   QoreZoneInfo::clearThreadCache();
+   QoreDateFormat::clearThreadCache();
+}
 
 void ThreadEntry::allocate(tid_node* tn, int stat) {
    assert(status == QTS_AVAIL);
@@ -448,9 +491,10 @@ void ThreadEntry::allocate(tid_node* tn, int stat) {
    assert(!thread_data);
 }
 
-void ThreadEntry::activate(int tid, pthread_t n_ptid, QoreProgram* p, bool foreign) {
+void ThreadEntry::activate(int tid, pthread_t n_ptid, QoreProgram* p, bool foreign, bool detached) {
    assert(status == QTS_NA || status == QTS_RESERVED);
    ptid = n_ptid;
+   joined = detached;
 #ifdef QORE_RUNTIME_THREAD_STACK_TRACE
    assert(callStack);
 #endif
@@ -827,9 +871,9 @@ void thread_uninstantiate_self() {
    td->tlpd->lvstack.uninstantiateSelf();
 }
 
-LocalVarValue* thread_find_lvar(const char* id) {
+LocalVarValue* thread_find_lvar(const char* id, std::atomic<int>& hint) {
    ThreadData* td = thread_data.get();
-   return td->tlpd->lvstack.find(id);
+   return td->tlpd->lvstack.find(id, hint);
 }
 
 ClosureVarValue* thread_instantiate_closure_var(const char* n_id, const QoreTypeInfo* typeInfo, QoreValue& nval, bool assign) {
@@ -959,6 +1003,14 @@ int remove_thread_resource(AbstractThreadResource* atr) {
    return td->trlist->remove(atr);
 }
 
+void set_thread_lock_resource(AbstractSmartLock* asl) {
+   thread_data.get()->trlist->setLock(asl);
+}
+
+int remove_thread_lock_resource(AbstractSmartLock* asl) {
+   return ThreadResourceList::removeLock(asl);
+}
+
 bool check_thread_resource(AbstractThreadResource* atr) {
    ThreadData* td = thread_data.get();
    return td->trlist->check(atr);
@@ -1417,6 +1469,11 @@ CodeContextHelperBase::CodeContextHelperBase(const char* code, QoreObject* obj,
    old_code = td->current_code;
    td->current_code = code;
 
+   old_ctx = td->current_ctx;
+   td->current_ctx = this;
+   call_file = td->runtime_loc.file;
+   call_line = td->runtime_loc.start_line;
+
    old_obj = td->current_obj;
    td->current_obj = obj;
 
@@ -1436,6 +1493,7 @@ CodeContextHelperBase::~CodeContextHelperBase() {
       qore_object_private::get(*td->current_obj)->endCall(xsink);
    }
    td->current_code = old_code;
+   td->current_ctx = old_ctx;
    td->current_obj = old_obj;
    td->current_class = old_class;
 }
@@ -1810,8 +1868,8 @@ void delete_signal_thread() {
 }
 
 // should only be called from the new thread
-void register_thread(int tid, pthread_t ptid, QoreProgram* p, bool foreign) {
-   thread_list.activate(tid, ptid, p, foreign);
+void register_thread(int tid, pthread_t ptid, QoreProgram* p, bool foreign, bool detached) {
+   thread_list.activate(tid, ptid, p, foreign, detached);
 }
 
 static void qore_thread_cleanup(void* n = 0) {
@@ -1955,12 +2013,26 @@ struct ThreadArg {
    }
 };
 
+// a native thread that can run more than one Qore thread; see QoreNativeThreadCache
+class QoreNativeThread {
+public:
+   // the thread function to run
+   void* (*f)(void*);
+   void* arg;
+   // signaled when a new thread function is assigned or when the thread should exit
+   QoreCondition cond;
+   bool exit = false;
+
+   DLLLOCAL QoreNativeThread(void* (*n_f)(void*), void* n_arg) : f(n_f), arg(n_arg) {
+   }
+};
+
 // put functions in an unnamed namespace to make them 'static extern "C"'
 namespace {
    extern "C" void* q_run_thread(void* arg) {
       ThreadArg* ta = (ThreadArg*)arg;
 
-      register_thread(ta->tid, pthread_self(), 0);
+      register_thread(ta->tid, pthread_self(), 0, false, true);
       printd(5, "q_run_thread() ta: %p TID %d started\n", ta, ta->tid);
 
       pthread_cleanup_push(qore_thread_cleanup, (void*)0);
@@ -1993,15 +2065,15 @@ namespace {
       }
 
       pthread_cleanup_pop((int)1);
+      thread_cache.finished();
       thread_counter.dec();
-      pthread_exit(0);
       return 0;
    }
 
    extern "C" void* op_background_thread(void* x) {
       BGThreadParams* btp = (BGThreadParams*) x;
       // register thread
-      register_thread(btp->tid, pthread_self(), btp->pgm);
+      register_thread(btp->tid, pthread_self(), btp->pgm, false, true);
       printd(5, "op_background_thread() btp: %p TID %d started\n", btp, btp->tid);
       //printf("op_background_thread() btp: %p TID %d started\n", btp, btp->tid);
 
@@ -2055,10 +2127,265 @@ namespace {
       }
 
       pthread_cleanup_pop(1);
+      thread_cache.finished();
       thread_counter.dec();
-      pthread_exit(0);
       return 0;
    }
+
+   // runs Qore threads in a native thread until the thread cache tells it to exit
+   extern "C" void* q_native_thread(void* arg) {
+      QoreNativeThread* nt = (QoreNativeThread*)arg;
+      // native threads are never joined
+      pthread_detach(pthread_self());
+
+      while (true) {
+         nt->f(nt->arg);
+         if (!thread_cache.park(nt))
+            break;
+         // thread-local state must not be carried over to the next Qore thread
+         reset_thread_local_caches();
+      }
+
+      thread_cache.exitThread(nt);
+      return 0;
+   }
+
+   // runs the sampling profiler's tick loop
+   extern "C" void* q_profile_sampler(void* arg) {
+      qore_profiler.run();
+      return 0;
+   }
+}
+
+int QoreNativeThreadCache::start(void* (*f)(void*), void* arg) {
+   {
+      AutoLocker al(l);
+      ++busy;
+      if (!idle.empty()) {
+         QoreNativeThread* nt = idle.back();
+         idle.pop_back();
+         nt->f = f;
+         nt->arg = arg;
+         nt->cond.signal();
+         return 0;
+      }
+      ++native_count;
+   }
+
+   QoreNativeThread* nt = new QoreNativeThread(f, arg);
+   pthread_t ptid;
+   int rc = pthread_create(&ptid, ta_default.get_ptr(), q_native_thread, nt);
+   if (rc) {
+      delete nt;
+      AutoLocker al(l);
+      --busy;
+      --native_count;
+   }
+   return rc;
+}
+
+void QoreNativeThreadCache::finished() {
+   AutoLocker al(l);
+   assert(busy);
+   --busy;
+}
+
+bool QoreNativeThreadCache::park(QoreNativeThread* nt) {
+   AutoLocker al(l);
+   if (stopped || idle.size() >= max_idle)
+      return false;
+
+   nt->f = nullptr;
+   idle.push_back(nt);
+   while (!nt->f && !nt->exit) {
+      if (nt->cond.wait2(&l, QORE_THREAD_CACHE_IDLE_TIMEOUT) && !nt->f && !nt->exit) {
+         // idle timeout: remove the thread from the cache and exit
+         idle.erase(std::find(idle.begin(), idle.end(), nt));
+         return false;
+      }
+   }
+   return !nt->exit;
+}
+
+unsigned QoreNativeThreadCache::setMax(unsigned n_max) {
+   AutoLocker al(l);
+   unsigned rc = max_idle;
+   max_idle = n_max;
+   releaseIntern(n_max);
+   return rc;
+}
+
+void QoreNativeThreadCache::exitThread(QoreNativeThread* nt) {
+   delete nt;
+   AutoLocker al(l);
+   assert(native_count);
+   --native_count;
+   if (stopped)
+      exit_cond.signal();
+}
+
+void QoreNativeThreadCache::shutdown() {
+   AutoLocker al(l);
+   stopped = true;
+   releaseIntern(0);
+   // wait for idle threads and threads that have finished their Qore thread but not yet been parked or exited;
+   // threads still running Qore code are not waited for
+   while (native_count > busy)
+      exit_cond.wait(&l);
+}
+
+void QoreNativeThreadCache::postFork(bool child) {
+   if (child) {
+      // idle threads do not exist in the child process
+      native_count -= idle.size();
+      idle.clear();
+   }
+   l.unlock();
+}
+
+void QoreNativeThreadCache::releaseIntern(size_t keep) {
+   // the least recently used threads exit first
+   while (idle.size() > keep) {
+      QoreNativeThread* nt = idle.front();
+      idle.erase(idle.begin());
+      nt->exit = true;
+      nt->cond.signal();
+   }
+}
+
+// appends a folded stack frame for the given code context and location
+static void profile_add_frame(std::string& frame, const char* code, const qore_class_private* qc, const char* file, int line) {
+   if (!code)
+      frame = "<top-level>";
+   else if (qc) {
+      frame = qc->name;
+      frame += "::";
+      frame += code;
+   }
+   else
+      frame = code;
+
+   if (file) {
+      frame += " (";
+      frame += file;
+      frame += ':';
+      frame += std::to_string(line);
+      frame += ')';
+   }
+
+   // ";" separates frames in folded stack output
+   std::replace(frame.begin(), frame.end(), ';', ',');
+}
+
+int QoreSamplingProfiler::start(int64 interval_ms, ExceptionSink* xsink) {
+   if (interval_ms <= 0) {
+      xsink->raiseException("PROFILE-ERROR", "the profiler sampling interval must be greater than zero; got: " QLLD, interval_ms);
+      return -1;
+   }
+
+   AutoLocker sal(sl);
+   AutoLocker al(l);
+   if (running) {
+      xsink->raiseException("PROFILE-ERROR", "the profiler is already running");
+      return -1;
+   }
+
+   interval = interval_ms;
+   start_tick = tick;
+   samples.clear();
+   running = true;
+
+   int rc = pthread_create(&ptid, ta_default.get_ptr(), q_profile_sampler, nullptr);
+   if (rc) {
+      running = false;
+      xsink->raiseErrnoException("PROFILE-ERROR", rc, "could not create profiler sampling thread");
+      return -1;
+   }
+   return 0;
+}
+
+QoreStringNode* QoreSamplingProfiler::stop() {
+   // the profiler cannot be restarted until the sampler thread has been joined
+   AutoLocker sal(sl);
+   QoreStringNode* rv;
+   pthread_t t;
+   {
+      AutoLocker al(l);
+      if (!running)
+         return 0;
+      running = false;
+      cond.signal();
+      rv = getIntern();
+      samples.clear();
+      t = ptid;
+   }
+
+   pthread_join(t, 0);
+   return rv;
+}
+
+QoreStringNode* QoreSamplingProfiler::get() const {
+   AutoLocker al(l);
+   return running ? getIntern() : 0;
+}
+
+QoreStringNode* QoreSamplingProfiler::getIntern() const {
+   QoreStringNode* rv = new QoreStringNode;
+   for (auto& i : samples)
+      rv->sprintf("%s " QLLD "\n", i.first.c_str(), i.second);
+   return rv;
+}
+
+void QoreSamplingProfiler::postFork(bool child) {
+   if (child) {
+      running = false;
+      samples.clear();
+   }
+   l.unlock();
+   sl.unlock();
+}
+
+void QoreSamplingProfiler::run() {
+   AutoLocker al(l);
+   while (running) {
+      cond.wait2(&l, interval);
+      if (running)
+         ++tick;
+   }
+}
+
+void QoreSamplingProfiler::sample() {
+   ThreadData* td = thread_data.get();
+   int64 t = tick.load(std::memory_order_relaxed);
+   int64 last = td->profile_tick;
+   if (last == t)
+      return;
+   td->profile_tick = t;
+
+   // build the folded stack starting with the innermost frame
+   std::vector<std::string> frames;
+   frames.emplace_back();
+   profile_add_frame(frames.back(), td->current_code, td->current_class, td->runtime_loc.file, td->runtime_loc.start_line);
+   for (const CodeContextHelperBase* ctx = td->current_ctx; ctx; ctx = ctx->old_ctx) {
+      frames.emplace_back();
+      profile_add_frame(frames.back(), ctx->old_code, ctx->old_class, ctx->call_file, ctx->call_line);
+   }
+
+   std::string stack;
+   for (std::vector<std::string>::reverse_iterator i = frames.rbegin(), e = frames.rend(); i != e; ++i) {
+      if (!stack.empty())
+         stack += ';';
+      stack += *i;
+   }
+
+   AutoLocker al(l);
+   if (!running)
+      return;
+   // ticks that elapsed before the profiler was started are not counted
+   if (last < start_tick)
+      last = start_tick;
+   if (t > last)
+      samples[stack] += t - last;
 }
 
 QoreValue do_op_background(const AbstractQoreNode* left, ExceptionSink* xsink) {
@@ -2093,12 +2420,9 @@ QoreValue do_op_background(const AbstractQoreNode* left, ExceptionSink* xsink) {
    //printd(5, "tp = %p\n", tp);
    // create thread
    int rc;
-   pthread_t ptid;
-
-   //printd(5, "calling pthread_create(%p, %p, %p, %p)\n", &ptid, &ta_default, op_background_thread, tp);
    thread_counter.inc();
 
-   if ((rc = pthread_create(&ptid, ta_default.get_ptr(), op_background_thread, tp))) {
+   if ((rc = thread_cache.start(op_background_thread, tp))) {
       tp->cleanup(xsink);
       tp->del();
 
@@ -2126,11 +2450,8 @@ int q_start_thread(ExceptionSink* xsink, q_thread_t f, void* arg) {
    //printd(5, "tp = %p\n", tp);
    // create thread
    int rc;
-   pthread_t ptid;
-
-   //printd(5, "calling pthread_create(%p, %p, %p, %p)\n", &ptid, &ta_default, op_background_thread, tp);
    thread_counter.inc();
-   if ((rc = pthread_create(&ptid, ta_default.get_ptr(), q_run_thread, ta))) {
+   if ((rc = thread_cache.start(q_run_thread, ta))) {
       delete ta;
       thread_counter.dec();
       deregister_thread(tid);
@@ -2248,6 +2569,14 @@ void delete_qore_threads() {
 
    pthread_mutexattr_destroy(&ma_recursive);
 
+   // make idle native threads exit and wait for them
+   thread_cache.shutdown();
+
+   // stop the profiler thread if running
+   QoreStringNode* profile = qore_profiler.stop();
+   if (profile)
+      profile->deref();
+
    assert(initial_thread);
    thread_list.deleteDataRelease(initial_thread);
 
@@ -2303,8 +2632,9 @@ QoreHashNode* QoreThreadList::getAllCallStacks() {
 
    while (i.next()) {
       // get call stack
-      if (entry[*i].callStack) {
-         QoreListNode* l = entry[*i].callStack->getCallStack();
+      ThreadEntry& e = entry(*i);
+      if (e.callStack) {
+         QoreListNode* l = e.callStack->getCallStack();
          if (!l->empty()) {
             // make hash entry
             str.clear();
@@ -2350,7 +2680,7 @@ void QoreThreadList::deleteData(int tid) {
 
 #ifdef DEBUG
    AutoLocker al(l);
-   entry[tid].thread_data = 0;
+   entry(tid).thread_data = 0;
 #endif
 }
 
@@ -2360,7 +2690,7 @@ void QoreThreadList::deleteDataRelease(int tid) {
 
    AutoLocker al(l);
 #ifdef DEBUG
-   entry[tid].thread_data = 0;
+   entry(tid).thread_data = 0;
 #endif
 
    releaseIntern(tid);
@@ -2384,13 +2714,13 @@ unsigned QoreThreadList::cancelAllActiveThreads() {
 
    while (i.next()) {
       if (*i != (unsigned)tid) {
-         //printf("QoreThreadList::cancelAllActiveThreads() canceling TID %d ptid: %p (this TID: %d)\n", *i, entry[*i].ptid, tid);
-         int trc = pthread_cancel(entry[*i].ptid);
+         //printf("QoreThreadList::cancelAllActiveThreads() canceling TID %d ptid: %p (this TID: %d)\n", *i, entry(*i).ptid, tid);
+         int trc = pthread_cancel(entry(*i).ptid);
          if (!trc)
             ++tcc;
 #ifdef DEBUG
          else
-            printd(0, "pthread_cancel() returned %d (%s) on tid %d (%p)\n", trc, strerror(trc), tid, entry[*i].ptid);
+            printd(0, "pthread_cancel() returned %d (%s) on tid %d (%p)\n", trc, strerror(trc), tid, entry(*i).ptid);
 #endif
       }
    }
@@ -2400,14 +2730,14 @@ unsigned QoreThreadList::cancelAllActiveThreads() {
 
 #ifdef QORE_RUNTIME_THREAD_STACK_TRACE
 void QoreThreadList::pushCall(CallNode* cn) {
-   entry[gettid()].callStack->push(cn);
+   entry(gettid()).callStack->push(cn);
 }
 
 void QoreThreadList::popCall(ExceptionSink* xsink) {
-   entry[gettid()].callStack->pop(xsink);
+   entry(gettid()).callStack->pop(xsink);
 }
 
 QoreListNode* QoreThreadList::getCallStackList() {
-   return entry[gettid()].callStack->getCallStack();
+   return entry(gettid()).callStack->getCallStack();
 }
 #endif
@@ -773,6 +773,7 @@ void AstTreePrinter::printParseOptionString(std::ostream& os, ASTParseOption* po
         case APOK_NO_TOP_LEVEL_STATEMENTS: os << "NO_TOP_LEVEL_STATEMENTS"; break;
         case APOK_NO_UNCONTROLLED_APIS: os << "NO_UNCONTROLLED_APIS"; break;
         case APOK_OLD_STYLE: os << "OLD_STYLE"; break;
+        case APOK_OPTIMIZE_ARITHMETIC: os << "OPTIMIZE_ARITHMETIC"; break;
         case APOK_PERL_BOOLEAN_EVAL: os << "PERL_BOOLEAN_EVAL"; break;
         case APOK_PUSH_PARSE_OPTIONS: os << "PUSH_PARSE_OPTIONS"; break;
         case APOK_REQUIRES: os << "REQUIRES"; break;
@@ -781,6 +782,7 @@ void AstTreePrinter::printParseOptionString(std::ostream& os, ASTParseOption* po
         case APOK_REQUIRE_PROTOTYPES: os << "REQUIRE_PROTOTYPES"; break;
         case APOK_REQUIRE_TYPES: os << "REQUIRE_TYPES"; break;
         case APOK_SET_TIME_ZONE: os << "SET_TIME_ZONE"; break;
+        case APOK_SHARE_MODULE_CLASSES: os << "SHARE_MODULE_CLASSES"; break;
         case APOK_STRICT_ARGS: os << "STRICT_ARGS"; break;
         case APOK_STRICT_BOOLEAN_EVAL: os << "STRICT_BOOLEAN_EVAL"; break;
         case APOK_STRONG_ENCAPSULATION: os << "STRONG_ENCAPSULATION"; break;
@@ -98,6 +98,7 @@ enum ASTParseOptionKind {
     APOK_NO_TOP_LEVEL_STATEMENTS,
     APOK_NO_UNCONTROLLED_APIS,
     APOK_OLD_STYLE,
+    APOK_OPTIMIZE_ARITHMETIC,
     APOK_PERL_BOOLEAN_EVAL,
     APOK_PUSH_PARSE_OPTIONS,
     APOK_REQUIRES,
@@ -106,6 +107,7 @@ enum ASTParseOptionKind {
     APOK_REQUIRE_PROTOTYPES,
     APOK_REQUIRE_TYPES,
     APOK_SET_TIME_ZONE,
+    APOK_SHARE_MODULE_CLASSES,
     APOK_STRICT_ARGS,
     APOK_STRICT_BOOLEAN_EVAL,
     APOK_STRONG_ENCAPSULATION,